@@ -7,7 +7,17 @@
  */
 
 #include "assembler.h"
+#include <climits>
+#include <cstdlib>
+#include <mutex>
 #include <string>
+#include <sys/stat.h>
+
+// Files pulled in by .INCLUDE, shared by every assembler in the process
+// and keyed by their real path, a file is read again once its
+// modification time changes
+static std::unordered_map<std::string, std::shared_ptr<const SourceFileType>> gSourceFileCache;
+static std::mutex gSourceFileCacheMutex;
 
 // add label and its address to symbol table
 void LabelMapType::AddLabel(const std::string &str, const unsigned address)
@@ -25,14 +35,77 @@ unsigned LabelMapType::GetAddress(const std::string &str) const
     return labels_.at(str);
 }
 
+void LabelMapType::WriteLabels(std::ostream &out) const
+{
+    std::vector<std::pair<unsigned, std::string>> sorted_labels;
+    for (const auto &label : labels_)
+    {
+        if (label.second > 0xFFFF)
+        {
+            // label defined before .ORIG
+            continue;
+        }
+        sorted_labels.push_back({label.second, label.first});
+    }
+    std::sort(sorted_labels.begin(), sorted_labels.end());
+    for (const auto &label : sorted_labels)
+    {
+        out << label.second << " x";
+        for (int shift = 12; shift >= 0; shift -= 4)
+        {
+            out << DecToChar((label.first >> shift) & 0xF);
+        }
+        out << std::endl;
+    }
+}
+
+std::unordered_set<unsigned> LabelMapType::LabeledAddresses() const
+{
+    std::unordered_set<unsigned> addresses;
+    for (const auto &label : labels_)
+    {
+        addresses.insert(label.second);
+    }
+    return addresses;
+}
+
+void LabelMapType::Relocate(const std::vector<unsigned> &removed_addresses)
+{
+    for (auto &label : labels_)
+    {
+        if (label.second > 0xFFFF)
+        {
+            // label defined before .ORIG
+            continue;
+        }
+        label.second -= std::lower_bound(removed_addresses.begin(), removed_addresses.end(),
+                                         label.second) -
+                        removed_addresses.begin();
+    }
+}
+
+// R0 - R7 or #DEC, operands that are only labels if a label is named so
+static bool IsRegisterOrDecimal(const std::string &str)
+{
+    return (str.size() == 2 && str[0] == 'R' && str[1] >= '0' && str[1] <= '7') ||
+           (!str.empty() && str[0] == '#');
+}
+
 std::string assembler::TranslateOprand(unsigned int current_address, std::string str, int opcode_length)
 {
     // Translate the oprand
     str = Trim(str);
-    auto item = label_map.GetAddress(str);
+    unsigned item = -1;
+    if (has_operand_like_label || !IsRegisterOrDecimal(str))
+    {
+        PhaseTimerType timer(stats.label_lookup_time);
+        item = label_map.GetAddress(str);
+        ++stats.label_lookups;
+    }
     if (item != -1)
     {
         // str is a label
+        ++stats.label_hits;
         // TO BE DONE
         int gap = item - current_address - 1;
         if (opcode_length == 11)
@@ -81,6 +154,8 @@ std::string assembler::LineLabelSplit(const std::string &line, int current_addre
         // save it in label_map
         // TO BE DONE
         label_map.AddLabel(first_token, current_address);
+        ++stats.labels;
+        has_operand_like_label = has_operand_like_label || IsRegisterOrDecimal(first_token);
         // remove label from the line
         if (first_whitespace_position == std::string::npos)
         {
@@ -93,30 +168,295 @@ std::string assembler::LineLabelSplit(const std::string &line, int current_addre
     return line;
 }
 
-// Scan #1: save commands and labels with their addresses
-int assembler::firstPass(std::string &input_filename)
+static int64_t ModifiedTime(const struct stat &file_stat)
+{
+    return int64_t(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec;
+}
+
+// `.INCLUDE "path"` with the path taken from the raw `line`, before it
+// was upper-cased; just `.INCLUDE` when the quotes are missing
+static std::string IncludeLine(const std::string &line)
+{
+    auto path_begin = line.find('"');
+    auto path_end = line.find('"', path_begin + 1);
+    if (path_begin == std::string::npos || path_end == std::string::npos)
+    {
+        return ".INCLUDE";
+    }
+    return ".INCLUDE " + line.substr(path_begin + 1, path_end - path_begin - 1);
+}
+
+// Name and parameters of a `.MACRO NAME PARAM...` line
+static std::string ReadMacroHeader(const std::string &line, MacroType &macro)
+{
+    std::stringstream line_stream(line.substr(7));
+    std::string name, parameter;
+    line_stream >> name;
+    while (line_stream >> parameter)
+    {
+        macro.parameters.push_back(parameter);
+    }
+    return name;
+}
+
+static bool IsReservedName(const std::string &name)
+{
+    return IsLC3Command(name) != -1 || IsLC3TrapRoutine(name) != -1 || IsLC3Pseudo(name) != -1;
+}
+
+// Read and format every line of `filename`
+int assembler::ReadSourceFile(const std::string &filename, SourceFileType &file)
 {
+    std::string contents;
+    {
+        PhaseTimerType timer(stats.read_time);
+        std::ifstream input_file(filename);
+        struct stat file_stat;
+        if (!input_file.is_open() || stat(filename.c_str(), &file_stat) != 0)
+        {
+            return -1;
+        }
+        file.modified_time = ModifiedTime(file_stat);
+        // Read the whole file at once, lines are split from memory
+        std::ostringstream buffer;
+        buffer << input_file.rdbuf();
+        contents = buffer.str();
+    }
+
+    PhaseTimerType timer(stats.format_time);
     std::string line;
-    std::ifstream input_file(input_filename);
-    if (!input_file.is_open())
+    size_t line_begin = 0;
+    while (line_begin < contents.size())
+    {
+        auto line_end = contents.find('\n', line_begin);
+        if (line_end == std::string::npos)
+        {
+            line_end = contents.size();
+        }
+        line.assign(contents, line_begin, line_end - line_begin);
+        line_begin = line_end + 1;
+        ++file.raw_line_count;
+
+        auto formatted_line = FormatLine(line);
+        if (formatted_line.empty())
+        {
+            continue;
+        }
+        if (formatted_line.compare(0, 9, ".INCLUDE ") == 0)
+        {
+            formatted_line = IncludeLine(line);
+        }
+        file.lines.push_back(formatted_line);
+    }
+    return 0;
+}
+
+// Get an included file from the cache, reading it on a miss
+int assembler::LoadIncludedFile(const std::string &filename,
+                                std::shared_ptr<const SourceFileType> &file)
+{
+    char real_path[PATH_MAX];
+    struct stat file_stat;
+    if (realpath(filename.c_str(), real_path) == nullptr || stat(real_path, &file_stat) != 0)
     {
-        std::cout << "Unable to open file" << std::endl;
-        // @ Input file read error
         return -1;
     }
+    ++stats.includes;
+    {
+        std::lock_guard<std::mutex> lock(gSourceFileCacheMutex);
+        auto iter = gSourceFileCache.find(real_path);
+        if (iter != gSourceFileCache.end() && iter->second->modified_time == ModifiedTime(file_stat))
+        {
+            ++stats.include_cache_hits;
+            file = iter->second;
+            return 0;
+        }
+    }
+    auto new_file = std::make_shared<SourceFileType>();
+    if (ReadSourceFile(real_path, *new_file) != 0)
+    {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(gSourceFileCacheMutex);
+    gSourceFileCache[real_path] = new_file;
+    file = new_file;
+    return 0;
+}
 
-    int orig_address = -1;
-    int current_address = -1;
+// An .INCLUDE path is relative to the directory of the including file
+static std::string IncludePath(const std::string &including_filename, const std::string &path)
+{
+    auto directory_end = including_filename.rfind('/');
+    if (path[0] == '/' || directory_end == std::string::npos)
+    {
+        return path;
+    }
+    return including_filename.substr(0, directory_end + 1) + path;
+}
 
-    while (std::getline(input_file, line))
+// Append the lines of `filename` to `lines`, with .INCLUDE and macros
+// expanded. The top level file (depth 0) is not cached.
+int assembler::ExpandFile(const std::string &filename, int depth, std::vector<std::string> &lines)
+{
+    std::shared_ptr<const SourceFileType> file;
+    if (depth == 0)
+    {
+        auto top_level_file = std::make_shared<SourceFileType>();
+        if (ReadSourceFile(filename, *top_level_file) != 0)
+        {
+            std::cout << "Unable to open file" << std::endl;
+            // @ Input file read error
+            return -1;
+        }
+        file = top_level_file;
+    }
+    else if (depth > kMaxIncludeDepth || LoadIncludedFile(filename, file) != 0)
     {
+        // not on stdout, which may be carrying the image
+        std::cerr << "Unable to include " << filename << std::endl;
+        // @ Error included file read error, or nested too deep
+        return -6;
+    }
+    stats.lines += file->raw_line_count;
 
-        line = FormatLine(line);
-        if (line.empty())
+    const auto &file_lines = file->lines;
+    for (size_t i = 0; i < file_lines.size(); ++i)
+    {
+        const auto &line = file_lines[i];
+        if (line.compare(0, 8, ".INCLUDE") == 0)
         {
+            if (line.size() <= 9)
+            {
+                // @ Error .INCLUDE without a quoted path
+                return -6;
+            }
+            auto status = ExpandFile(IncludePath(filename, line.substr(9)), depth + 1, lines);
+            if (status != 0)
+            {
+                return status;
+            }
             continue;
         }
+        if (line.compare(0, 7, ".MACRO ") == 0)
+        {
+            MacroType macro;
+            auto name = ReadMacroHeader(line, macro);
+            for (++i; i < file_lines.size() && file_lines[i] != ".ENDM"; ++i)
+            {
+                macro.body.push_back(file_lines[i]);
+            }
+            if (i == file_lines.size() || IsReservedName(name))
+            {
+                // @ Error .MACRO without .ENDM, or named after an opcode
+                return -7;
+            }
+            macros[name] = macro;
+            continue;
+        }
+        auto status = ExpandLine(line, 0, lines);
+        if (status != 0)
+        {
+            return status;
+        }
+    }
+    return 0;
+}
 
+// Append `line` to `lines`, or the body of the macro it invokes
+int assembler::ExpandLine(const std::string &line, int depth, std::vector<std::string> &lines)
+{
+    std::vector<std::string> tokens;
+    std::stringstream line_stream(line);
+    std::string token;
+    while (line_stream >> token)
+    {
+        tokens.push_back(token);
+    }
+    // "NAME ARG..." or "LABEL NAME ARG..."
+    size_t name_index = 0;
+    auto iter = macros.find(tokens[0]);
+    if (iter == macros.end() && tokens.size() > 1)
+    {
+        name_index = 1;
+        iter = macros.find(tokens[1]);
+    }
+    if (iter == macros.end())
+    {
+        lines.push_back(line);
+        return 0;
+    }
+
+    const auto &macro = iter->second;
+    if (depth >= kMaxMacroDepth || tokens.size() - name_index - 1 != macro.parameters.size())
+    {
+        // @ Error wrong number of macro arguments, or recursive macro
+        return -8;
+    }
+    if (name_index == 1)
+    {
+        // the label goes on a line of its own, in front of the body
+        lines.push_back(tokens[0]);
+    }
+    ++stats.macro_expansions;
+    const auto unique_suffix = std::to_string(stats.macro_expansions);
+    for (const auto &body_line : macro.body)
+    {
+        if (body_line.compare(0, 8, ".INCLUDE") == 0)
+        {
+            // @ Error .INCLUDE in a macro body
+            return -6;
+        }
+        if (body_line.compare(0, 6, ".MACRO") == 0)
+        {
+            // @ Error .MACRO in a macro body
+            return -7;
+        }
+        std::stringstream body_stream(body_line);
+        std::string expanded_line;
+        while (body_stream >> token)
+        {
+            for (size_t j = 0; j < macro.parameters.size(); ++j)
+            {
+                if (token == macro.parameters[j])
+                {
+                    token = tokens[name_index + 1 + j];
+                    break;
+                }
+            }
+            for (auto position = token.find('@'); position != std::string::npos;
+                 position = token.find('@', position))
+            {
+                token.replace(position, 1, unique_suffix);
+            }
+            expanded_line += expanded_line.empty() ? token : " " + token;
+        }
+        auto status = ExpandLine(expanded_line, depth + 1, lines);
+        if (status != 0)
+        {
+            return status;
+        }
+    }
+    return 0;
+}
+
+// Scan #1: save commands and labels with their addresses
+int assembler::firstPass(std::string &input_filename)
+{
+    PhaseTimerType timer(stats.first_pass_time);
+
+    // Source lines with every .INCLUDE and macro expanded
+    std::vector<std::string> lines;
+    auto expand_status = ExpandFile(input_filename, 0, lines);
+    if (expand_status != 0)
+    {
+        return expand_status;
+    }
+
+    int orig_address = -1;
+    int current_address = -1;
+
+    for (const auto &line : lines)
+    {
         auto command = LineLabelSplit(line, current_address);
         if (command.empty())
         {
@@ -196,56 +536,245 @@ int assembler::firstPass(std::string &input_filename)
     return 0;
 }
 
-std::string assembler::TranslatePseudo(std::stringstream &command_stream)
+// Condition bits of a BR opcode (N = 4, Z = 2, P = 1), 0 if not a branch
+static int BranchConditions(const std::string &opcode)
+{
+    if (opcode.compare(0, 2, "BR") != 0 || IsLC3Command(opcode) == -1)
+    {
+        return 0;
+    }
+    if (opcode.size() == 2)
+    {
+        // BR is BRNZP
+        return 7;
+    }
+    int conditions = 0;
+    for (auto iter = opcode.begin() + 2; iter != opcode.end(); iter++)
+    {
+        conditions |= *iter == 'N' ? 4 : (*iter == 'Z' ? 2 : 1);
+    }
+    return conditions;
+}
+
+// Opcodes whose last operand is a PC offset
+static bool IsPCRelative(const std::string &opcode)
+{
+    return BranchConditions(opcode) != 0 || opcode == "JSR" || opcode == "LD" ||
+           opcode == "LDI" || opcode == "LEA" || opcode == "ST" || opcode == "STI";
+}
+
+// Opcodes setting the condition codes from their destination register
+static bool SetsConditionCode(const std::string &opcode)
+{
+    return opcode == "ADD" || opcode == "AND" || opcode == "NOT" || opcode == "LD" ||
+           opcode == "LDI" || opcode == "LDR";
+}
+
+// ADD Rx, Rx, #0 only sets the condition codes from Rx
+static bool IsConditionCodeSetter(const std::vector<std::string> &tokens)
+{
+    return tokens.size() == 4 && tokens[0] == "ADD" && tokens[1] == tokens[2] &&
+           tokens[1][0] == 'R' && tokens[3][0] != 'R' && RecognizeNumberValue(tokens[3]) == 0;
+}
+
+// Peephole pass on the commands of the first scan:
+// 1. branch chaining: a branch to a branch taken whenever it is taken
+//    goes straight to the final target
+// 2. jump-to-next: a branch to the instruction after it is removed
+// 3. ADD Rx, Rx, #0 is removed when the instruction before it already set
+//    the condition codes from Rx, or the one after it sets them again
+// then the addresses and labels are laid out again.
+// Code addresses are assumed to only come from labels, the pass does
+// nothing if any PC offset is written as a number.
+void assembler::optimize()
+{
+    // longest chain of branches followed, also breaks branch cycles
+    const int kMaxChainLength = 16;
+    PhaseTimerType timer(stats.optimize_time);
+
+    const size_t count = commands.size();
+    std::vector<unsigned> addresses(count);
+    std::vector<std::vector<std::string>> tokens(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        addresses[i] = std::get<0>(commands[i]);
+        if (std::get<2>(commands[i]) != CommandType::OPERATION)
+        {
+            continue;
+        }
+        std::stringstream command_stream(std::get<1>(commands[i]));
+        std::string token;
+        while (command_stream >> token)
+        {
+            tokens[i].push_back(token);
+        }
+        if (IsPCRelative(tokens[i][0]) &&
+            (tokens[i].size() < 2 || label_map.GetAddress(tokens[i].back()) == -1))
+        {
+            // numeric PC offset, moving code would break it
+            return;
+        }
+    }
+    const auto labeled_addresses = label_map.LabeledAddresses();
+    std::vector<bool> removed(count);
+    // first command at `address` or after it
+    auto find_command = [&](unsigned address) -> size_t {
+        return std::lower_bound(addresses.begin(), addresses.end(), address) - addresses.begin();
+    };
+    auto next_live = [&](size_t index) {
+        while (index < count && removed[index])
+        {
+            ++index;
+        }
+        return index;
+    };
+    auto is_operation = [&](size_t index) {
+        return index < count && std::get<2>(commands[index]) == CommandType::OPERATION;
+    };
+
+    // Branch chaining
+    for (size_t i = 0; i < count; ++i)
+    {
+        const int conditions = is_operation(i) ? BranchConditions(tokens[i][0]) : 0;
+        if (conditions == 0)
+        {
+            continue;
+        }
+        bool is_chained = false;
+        for (int chain_length = 0; chain_length < kMaxChainLength; ++chain_length)
+        {
+            auto target_address = label_map.GetAddress(tokens[i].back());
+            auto target = find_command(target_address);
+            if (!is_operation(target) || addresses[target] != target_address ||
+                (BranchConditions(tokens[target][0]) & conditions) != conditions)
+            {
+                break;
+            }
+            auto final_address = label_map.GetAddress(tokens[target].back());
+            int offset = int(final_address) - int(addresses[i]) - 1;
+            if (final_address == target_address || offset < -256 || offset > 255)
+            {
+                // a loop on itself, or out of reach
+                break;
+            }
+            tokens[i].back() = tokens[target].back();
+            is_chained = true;
+        }
+        stats.branches_chained += is_chained;
+    }
+
+    // Removal, until nothing changes
+    bool is_changed = true;
+    while (is_changed)
+    {
+        is_changed = false;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (removed[i] || !is_operation(i))
+            {
+                continue;
+            }
+            const auto next = next_live(i + 1);
+            bool is_removable = false;
+            if (BranchConditions(tokens[i][0]) != 0)
+            {
+                auto target_address = label_map.GetAddress(tokens[i].back());
+                auto target = find_command(target_address);
+                is_removable = (target == count || addresses[target] == target_address) &&
+                               next_live(target) == next;
+            }
+            else if (IsConditionCodeSetter(tokens[i]))
+            {
+                const auto &reg = tokens[i][1];
+                // dead: overwritten before any branch can read them
+                is_removable = is_operation(next) && SetsConditionCode(tokens[next][0]);
+                // redundant: the instruction falling into it set them from Rx,
+                // and nothing jumps in between
+                size_t previous = i;
+                bool is_jump_target = labeled_addresses.count(addresses[i]) != 0;
+                while (previous > 0 && removed[previous - 1])
+                {
+                    --previous;
+                    is_jump_target |= labeled_addresses.count(addresses[previous]) != 0;
+                }
+                if (previous > 0 && !is_jump_target)
+                {
+                    --previous;
+                    is_removable |= is_operation(previous) &&
+                                    SetsConditionCode(tokens[previous][0]) &&
+                                    tokens[previous][1] == reg;
+                }
+            }
+            if (is_removable)
+            {
+                removed[i] = true;
+                is_changed = true;
+                ++stats.instructions_removed;
+            }
+        }
+    }
+
+    // Lay out the addresses and labels again
+    std::vector<unsigned> removed_addresses;
+    Commands optimized_commands;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (removed[i])
+        {
+            removed_addresses.push_back(addresses[i]);
+            continue;
+        }
+        auto command = std::get<1>(commands[i]);
+        if (std::get<2>(commands[i]) == CommandType::OPERATION)
+        {
+            command = tokens[i][0];
+            for (auto iter = tokens[i].begin() + 1; iter != tokens[i].end(); iter++)
+            {
+                command += " " + *iter;
+            }
+        }
+        optimized_commands.push_back({addresses[i] - unsigned(removed_addresses.size()), command,
+                                      std::get<2>(commands[i])});
+    }
+    commands = std::move(optimized_commands);
+    label_map.Relocate(removed_addresses);
+}
+
+void assembler::TranslatePseudo(std::stringstream &command_stream, std::vector<uint16_t> &words)
 {
     std::string pseudo_opcode;
-    std::string output_line;
     command_stream >> pseudo_opcode;
     if (pseudo_opcode == ".FILL")
     {
         std::string number_str;
         command_stream >> number_str;
-        output_line = NumberToAssemble(number_str);
-        if (gIsHexMode)
-            output_line = ConvertBin2Hex(output_line);
+        words.push_back(RecognizeNumberValue(number_str));
     }
     else if (pseudo_opcode == ".BLKW")
     {
         // Fill 0 here
-        // TO BE DONE
         std::string number_str;
         command_stream >> number_str;
         int number = RecognizeNumberValue(number_str);
         for (int i = 0; i < number; i++)
         {
-            std::string s = NumberToAssemble(0);
-            if (gIsHexMode)
-                s = ConvertBin2Hex(s);
-            output_line += s;
-            output_line.push_back('\n');
+            words.push_back(0);
         }
-        output_line.erase(output_line.end() - 1);
     }
     else if (pseudo_opcode == ".STRINGZ")
     {
         // Fill string here
-        // TO BE DONE
         std::string str;
         command_stream >> str;
         for (auto iter = str.begin() + 1; iter != str.end() - 1; iter++)
         {
-            std::string s = NumberToAssemble(int(*iter));
-            if (gIsHexMode)
-                s = ConvertBin2Hex(s);
-            output_line += s;
-            output_line.push_back('\n');
+            words.push_back(int(*iter));
         }
-        output_line += NumberToAssemble(0);
+        words.push_back(0);
     }
-    return output_line;
 }
 
-std::string assembler::TranslateCommand(std::stringstream &command_stream, unsigned int current_address)
+uint16_t assembler::TranslateCommand(std::stringstream &command_stream, unsigned int current_address)
 {
     std::string opcode;
     command_stream >> opcode;
@@ -278,7 +807,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 3)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1]);
@@ -302,7 +832,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 3)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1]);
@@ -326,7 +857,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 9);
             break;
@@ -337,7 +869,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 9);
             break;
@@ -348,7 +881,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 9);
             break;
@@ -359,7 +893,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 9);
             break;
@@ -370,7 +905,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 9);
             break;
@@ -381,7 +917,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 9);
             break;
@@ -392,7 +929,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 9);
             break;
@@ -404,7 +942,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 9);
             break;
@@ -413,7 +952,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += "000000";
@@ -425,7 +965,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0], 11);
             break;
@@ -436,7 +977,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += "000000";
@@ -448,7 +990,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 2)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1], 9);
@@ -460,7 +1003,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 2)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1], 9);
@@ -472,7 +1016,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 3)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1]);
@@ -485,7 +1030,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 2)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1], 9);
@@ -497,10 +1043,12 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 2)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1]);
+            output_line += "111111";
             break;
             // "NOT"
             // TO BE DONE
@@ -510,7 +1058,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 0)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             break;
         case 19:
@@ -518,7 +1067,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 0)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             break;
             // RTI
@@ -529,7 +1079,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 2)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1], 9);
@@ -539,7 +1090,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 2)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1], 9);
@@ -551,7 +1103,8 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 3)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
             output_line += TranslateOprand(current_address, operand_list[0]);
             output_line += TranslateOprand(current_address, operand_list[1]);
@@ -563,11 +1116,19 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
             if (operand_list_size != 1)
             {
                 // @ Error operand numbers
-                exit(-30);
+                translate_status = -30;
+                return 0;
             }
-            command_tag = operand_list[0][2] - '0';
-            output_line = kLC3TrapMachineCode[command_tag];
-            break;
+        {
+            auto trap_vector = RecognizeNumberValue(operand_list[0]);
+            if (trap_vector < 0 || trap_vector > 0xFF)
+            {
+                // @ Error trap vector
+                translate_status = -30;
+                return 0;
+            }
+            return uint16_t(0xF000 | trap_vector);
+        }
             // TRAP
             // TO BE DONE
         default:
@@ -577,14 +1138,43 @@ std::string assembler::TranslateCommand(std::stringstream &command_stream, unsig
         }
     }
 
-    if (gIsHexMode)
-        output_line = ConvertBin2Hex(output_line);
+    // the first 16 digits, as std::bitset<16> reads them, without throwing
+    // on an operand that did not translate to 0 / 1
+    uint16_t word = 0;
+    for (size_t i = 0; i < output_line.size() && i < 16; ++i)
+    {
+        word = uint16_t(word << 1) | (output_line[i] == '1' ? 1 : 0);
+    }
+    return word;
+}
 
-    return output_line;
+// Append `words` to `output` as text lines, binary or hex
+static void FormatWords(const std::vector<uint16_t> &words, bool is_hex, std::string &output)
+{
+    auto begin = output.size();
+    if (is_hex)
+    {
+        output.resize(begin + words.size() * kHexWordLineLength);
+        FormatHexWords(words.data(), words.size(), &output[begin]);
+    }
+    else
+    {
+        output.resize(begin + words.size() * kBinaryWordLineLength);
+        FormatBinaryWords(words.data(), words.size(), &output[begin]);
+    }
+}
+
+void assembler::EmitWords(std::vector<uint16_t> &words, bool is_hex, std::string &output)
+{
+    PhaseTimerType timer(stats.output_time);
+    stats.words += words.size();
+    FormatWords(words, is_hex, output);
+    words.clear();
 }
 
 int assembler::secondPass(std::string &output_filename)
 {
+    PhaseTimerType second_pass_timer(stats.second_pass_time);
     // Scan #2:
     // Translate
     std::ofstream output_file;
@@ -596,6 +1186,9 @@ int assembler::secondPass(std::string &output_filename)
         return -20;
     }
 
+    // Words are collected and formatted in blocks
+    std::vector<uint16_t> words;
+    std::string output_buffer;
     for (const auto &command : commands)
     {
         const unsigned address = std::get<0>(command);
@@ -606,14 +1199,40 @@ int assembler::secondPass(std::string &output_filename)
         if (command_type == CommandType::PSEUDO)
         {
             // Pseudo
-            output_file << TranslatePseudo(command_stream) << std::endl;
+            TranslatePseudo(command_stream, words);
+            if (gIsHexMode && command_content.compare(0, 8, ".STRINGZ") == 0)
+            {
+                // The zero ending a string has always been written in
+                // binary even in hex mode, keep the images unchanged
+                words.pop_back();
+                EmitWords(words, true, output_buffer);
+                words.push_back(0);
+                EmitWords(words, false, output_buffer);
+            }
         }
         else
         {
             // LC3 command
-            output_file << TranslateCommand(command_stream, address) << std::endl;
+            words.push_back(TranslateCommand(command_stream, address));
+            if (translate_status != 0)
+            {
+                return translate_status;
+            }
+        }
+
+        if (words.size() >= kOutputBlockSize)
+        {
+            EmitWords(words, gIsHexMode, output_buffer);
+            PhaseTimerType timer(stats.output_time);
+            stats.bytes_written += output_buffer.size();
+            output_file.write(output_buffer.data(), output_buffer.size());
+            output_buffer.clear();
         }
     }
+    EmitWords(words, gIsHexMode, output_buffer);
+    PhaseTimerType timer(stats.output_time);
+    stats.bytes_written += output_buffer.size();
+    output_file.write(output_buffer.data(), output_buffer.size());
 
     // Close the output file
     output_file.close();
@@ -621,14 +1240,335 @@ int assembler::secondPass(std::string &output_filename)
     return 0;
 }
 
+// The label a PC relative instruction still waits for, empty when its
+// offset can be worked out now. "XA" or "#1" may still turn out to be
+// labels further down, so any operand that is not a known label waits;
+// it is read as a number only if it is still undefined at the flush.
+std::string assembler::ForwardLabel(const std::string &opcode, const std::string &command) const
+{
+    if (!IsPCRelative(opcode))
+    {
+        return "";
+    }
+    auto operand = command.substr(command.rfind(' ') + 1);
+    if (label_map.GetAddress(operand) != unsigned(-1))
+    {
+        return "";
+    }
+    return operand;
+}
+
+// Translate the instructions held back for `label`, now defined
+void assembler::ResolveWaiting(const std::string &label)
+{
+    auto iter = stream.waiting.find(label);
+    if (iter == stream.waiting.end())
+    {
+        return;
+    }
+    for (auto sequence : iter->second)
+    {
+        if (sequence < stream.window_begin)
+        {
+            // given up on and written out already
+            continue;
+        }
+        auto &entry = stream.window[sequence - stream.window_begin];
+        auto command_stream = std::stringstream(entry.command);
+        entry.word = TranslateCommand(command_stream, entry.address);
+        entry.is_resolved = true;
+        entry.command.clear();
+    }
+    stream.waiting.erase(iter);
+}
+
+// One line of the streaming mode, the first scan and the second one
+// at once
+int assembler::StreamLine(const std::string &line)
+{
+    auto command = LineLabelSplit(line, stream.current_address);
+    if (command.size() != line.size())
+    {
+        ResolveWaiting(line.substr(0, line.find(' ')));
+    }
+    if (command.empty())
+    {
+        return 0;
+    }
+
+    auto first_whitespace_position = command.find(' ');
+    auto first_token = command.substr(0, first_whitespace_position);
+    if (first_token == ".ORIG")
+    {
+        stream.orig_address = RecognizeNumberValue(command.substr(first_whitespace_position + 1));
+        if (stream.orig_address == std::numeric_limits<int>::max())
+        {
+            // @ Error address
+            return -2;
+        }
+        stream.current_address = stream.orig_address;
+        return 0;
+    }
+    if (stream.orig_address == -1)
+    {
+        // @ Error Program begins before .ORIG
+        return -3;
+    }
+    if (first_token == ".END")
+    {
+        stream.is_end = true;
+        return 0;
+    }
+
+    StreamWordType entry;
+    entry.address = stream.current_address;
+    entry.is_hex = gIsHexMode;
+    if (IsLC3Command(first_token) != -1 || IsLC3TrapRoutine(first_token) != -1)
+    {
+        auto label = ForwardLabel(first_token, command);
+        if (label.empty())
+        {
+            auto command_stream = std::stringstream(command);
+            entry.word = TranslateCommand(command_stream, entry.address);
+        }
+        else
+        {
+            entry.is_resolved = false;
+            entry.command = command;
+            stream.waiting[label].push_back(stream.window_begin + stream.window.size());
+        }
+        stream.window.push_back(entry);
+        stream.current_address += 1;
+        return 0;
+    }
+
+    // Pseudo code, the same checks and address steps as firstPass
+    auto operand = command.substr(first_whitespace_position + 1);
+    if (first_token == ".FILL")
+    {
+        auto num_temp = RecognizeNumberValue(operand);
+        if (num_temp == std::numeric_limits<int>::max())
+        {
+            // @ Error Invalid Number input @ FILL
+            return -4;
+        }
+        if (num_temp > 65535 || num_temp < -65536)
+        {
+            // @ Error Too large or too small value  @ FILL
+            return -5;
+        }
+        stream.current_address += 1;
+    }
+    if (first_token == ".BLKW")
+    {
+        stream.current_address += RecognizeNumberValue(operand);
+    }
+    if (first_token == ".STRINGZ")
+    {
+        stream.current_address += operand.size() - 1;
+    }
+    std::vector<uint16_t> words;
+    auto command_stream = std::stringstream(command);
+    TranslatePseudo(command_stream, words);
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        entry.word = words[i];
+        entry.is_hex = gIsHexMode && !(first_token == ".STRINGZ" && i + 1 == words.size());
+        stream.window.push_back(entry);
+    }
+    return 0;
+}
+
+void assembler::FlushStream(std::ostream &output_stream, bool is_final)
+{
+    std::vector<uint16_t> words;
+    std::string output_buffer;
+    bool is_hex = gIsHexMode;
+    while (!stream.window.empty())
+    {
+        auto &entry = stream.window.front();
+        if (!entry.is_resolved)
+        {
+            if (!is_final && stream.window.size() <= kStreamWindowSize)
+            {
+                break;
+            }
+            // the label is out of reach or never defined, the operand is
+            // read the way the two scans read an unknown label
+            auto command_stream = std::stringstream(entry.command);
+            entry.word = TranslateCommand(command_stream, entry.address);
+        }
+        if (entry.is_hex != is_hex)
+        {
+            EmitWords(words, is_hex, output_buffer);
+            is_hex = entry.is_hex;
+        }
+        words.push_back(entry.word);
+        stream.window.pop_front();
+        ++stream.window_begin;
+    }
+    EmitWords(words, is_hex, output_buffer);
+    stats.bytes_written += output_buffer.size();
+    output_stream.write(output_buffer.data(), output_buffer.size());
+}
+
+// Scans both passes over `input_stream` at once. Words are written as
+// soon as everything before them is known; memory grows with the forward
+// references in flight (at most kStreamWindowSize words), not with the
+// program. .INCLUDE paths are relative to the directory of
+// `input_filename`, or to the working directory for stdin ("-").
+int assembler::StreamLines(const std::string &input_filename, std::istream &input_stream,
+                           std::ostream &output_stream)
+{
+    std::string line;
+    std::string macro_name;
+    MacroType macro;
+    bool is_in_macro = false;
+    std::vector<std::string> lines;
+    while (!stream.is_end && std::getline(input_stream, line))
+    {
+        ++stats.lines;
+        auto formatted_line = FormatLine(line);
+        if (formatted_line.empty())
+        {
+            continue;
+        }
+        if (is_in_macro)
+        {
+            if (formatted_line == ".ENDM")
+            {
+                macros[macro_name] = macro;
+                is_in_macro = false;
+            }
+            else
+            {
+                macro.body.push_back(formatted_line);
+            }
+            continue;
+        }
+        if (formatted_line.compare(0, 7, ".MACRO ") == 0)
+        {
+            macro = MacroType();
+            macro_name = ReadMacroHeader(formatted_line, macro);
+            if (IsReservedName(macro_name))
+            {
+                // @ Error .MACRO named after an opcode
+                return -7;
+            }
+            is_in_macro = true;
+            continue;
+        }
+
+        lines.clear();
+        int status;
+        if (formatted_line.compare(0, 9, ".INCLUDE ") == 0)
+        {
+            auto include_line = IncludeLine(line);
+            if (include_line.size() <= 9)
+            {
+                // @ Error .INCLUDE without a quoted path
+                return -6;
+            }
+            auto path = include_line.substr(9);
+            status = ExpandFile(input_filename == "-" ? path : IncludePath(input_filename, path), 1,
+                                lines);
+        }
+        else
+        {
+            status = ExpandLine(formatted_line, 0, lines);
+        }
+        if (status != 0)
+        {
+            return status;
+        }
+        for (const auto &expanded_line : lines)
+        {
+            status = StreamLine(expanded_line);
+            if (status == 0)
+            {
+                status = translate_status;
+            }
+            if (status != 0)
+            {
+                return status;
+            }
+            if (stream.is_end)
+            {
+                break;
+            }
+        }
+
+        FlushStream(output_stream, false);
+        if (input_stream.rdbuf()->in_avail() <= 0)
+        {
+            // nothing more to read right now, pass the words on down the
+            // pipe instead of waiting for a full buffer
+            output_stream.flush();
+        }
+    }
+    if (is_in_macro)
+    {
+        // @ Error .MACRO without .ENDM
+        return -7;
+    }
+    FlushStream(output_stream, true);
+    output_stream.flush();
+    return translate_status;
+}
+
+// "-" is stdin for the input and stdout for the output
+int assembler::assembleStream(const std::string &input_filename, const std::string &output_filename)
+{
+    std::ifstream input_file;
+    if (input_filename != "-")
+    {
+        input_file.open(input_filename);
+        if (!input_file.is_open())
+        {
+            std::cerr << "Unable to open file" << std::endl;
+            // @ Input file read error
+            return -1;
+        }
+    }
+    std::ofstream output_file;
+    if (output_filename != "-")
+    {
+        output_file.open(output_filename);
+        if (!output_file)
+        {
+            // @ Error at output file
+            return -20;
+        }
+    }
+    return StreamLines(input_filename, input_filename == "-" ? std::cin : input_file,
+                       output_filename == "-" ? std::cout : output_file);
+}
+
 // assemble main function
 int assembler::assemble(std::string &input_filename, std::string &output_filename)
 {
+    stats = AssemblerStatsType();
+    macros.clear();
+    translate_status = 0;
+    has_operand_like_label = false;
+    if (input_filename == "-" || output_filename == "-")
+    {
+        // * Streaming Mode:
+        // * One pass, see StreamLines
+        stream = StreamStateType();
+        PhaseTimerType timer(stats.total_time);
+        return assembleStream(input_filename, output_filename);
+    }
+    PhaseTimerType timer(stats.total_time);
     auto first_scan_status = firstPass(input_filename);
     if (first_scan_status != 0)
     {
         return first_scan_status;
     }
+    if (is_optimize)
+    {
+        optimize();
+    }
     auto second_scan_status = secondPass(output_filename);
     if (second_scan_status != 0)
     {
@@ -637,3 +1577,16 @@ int assembler::assemble(std::string &input_filename, std::string &output_filenam
     // OK flag
     return 0;
 }
+
+// write the label table next to the image
+int assembler::exportLabels(const std::string &label_filename) const
+{
+    std::ofstream label_file(label_filename);
+    if (!label_file)
+    {
+        // @ Error at label file
+        return -21;
+    }
+    label_map.WriteLabels(label_file);
+    return 0;
+}
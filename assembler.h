@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <ostream>
@@ -15,10 +16,24 @@
 #include <cstring>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <bitset>
+#include <limits>
+#include <memory>
+
+#include "assembler_stats.h"
+#include "formatter.h"
 
 const int kLC3LineLength = 16;
+// nesting limits, also catch files including themselves and recursive macros
+const int kMaxIncludeDepth = 16;
+const int kMaxMacroDepth = 64;
+// words formatted before the output is written out
+const size_t kOutputBlockSize = 1 << 16;
+// words held back in streaming mode before a forward reference is given
+// up on, more than the reach of any PC offset (11 bits for JSR)
+const size_t kStreamWindowSize = 1 << 11;
 
 extern bool gIsErrorLogMode;
 extern bool gIsHexMode;
@@ -74,6 +89,52 @@ const std::vector<std::string> kLC3TrapMachineCode({"1111000000100000",
                                                     "1111000000100100",
                                                     "1111000000100101"});
 
+// A source file after FormatLine, without the empty lines.
+// `.INCLUDE "path"` lines keep the path as written (not upper-cased).
+struct SourceFileType
+{
+    std::vector<std::string> lines;
+    // lines in the file, for the statistics
+    size_t raw_line_count = 0;
+    // modification time (ns) when the file was read
+    int64_t modified_time = 0;
+};
+
+// `.MACRO NAME PARAM...` ... `.ENDM`: a line `NAME ARG...` is replaced by
+// the body with every PARAM token replaced by its ARG, and every '@'
+// by a number unique to the expansion (for labels such as LOOP@)
+struct MacroType
+{
+    std::vector<std::string> parameters;
+    std::vector<std::string> body;
+};
+
+// A word of the streaming output, an instruction with a forward
+// reference is kept as text until its label is defined
+struct StreamWordType
+{
+    uint16_t word = 0;
+    bool is_resolved = true;
+    // the zero ending a .STRINGZ is written in binary even in hex mode
+    bool is_hex = false;
+    unsigned address = 0;
+    std::string command;
+};
+
+// State of the one-pass streaming mode (-f - / -o -)
+struct StreamStateType
+{
+    int orig_address = -1;
+    int current_address = -1;
+    bool is_end = false;
+    // words not written out yet, from the first unresolved one on
+    std::deque<StreamWordType> window;
+    // sequence number of window.front()
+    uint64_t window_begin = 0;
+    // label -> sequence numbers of the instructions waiting for it
+    std::unordered_map<std::string, std::vector<uint64_t>> waiting;
+};
+
 enum CommandType
 {
     OPERATION,
@@ -99,6 +160,13 @@ private:
 public:
     void AddLabel(const std::string &str, unsigned address);
     unsigned GetAddress(const std::string &str) const;
+    // write "LABEL xADDR" lines sorted by address, for the simulator tools
+    void WriteLabels(std::ostream &out) const;
+    // addresses that carry at least one label
+    std::unordered_set<unsigned> LabeledAddresses() const;
+    // move every label down by the number of `removed_addresses` (sorted)
+    // before it, a label on a removed word moves to the word after it
+    void Relocate(const std::vector<unsigned> &removed_addresses);
 };
 
 static inline int IsLC3Pseudo(const std::string &str)
@@ -232,65 +300,6 @@ static int RecognizeNumberValue(const std::string &str)
     }
 }
 
-static std::string NumberToAssemble(const int &number)
-{
-    // Convert `number` into a 16 bit binary string
-    // TO BE DONE
-    return std::bitset<16>(number).to_string();
-}
-
-static std::string NumberToAssemble(const std::string &number)
-{
-    // Convert `number` into a 16 bit binary string
-    // You might use `RecognizeNumberValue` in this function
-    // TO BE DONE
-    return std::bitset<16>(RecognizeNumberValue(number)).to_string();
-}
-
-static std::string ConvertBin2Hex(const std::string &bin)
-{
-    // Convert the binary string `bin` into a hex string
-    // TO BE DONE
-    std::string s;
-    for (int i = 0; i < bin.size(); i += 4)
-    {
-        std::string tmp = bin.substr(i, 4);
-        if (!tmp.compare("0000"))
-            s.push_back('0');
-        else if (!tmp.compare("0001"))
-            s.push_back('1');
-        else if (!tmp.compare("0010"))
-            s.push_back('2');
-        else if (!tmp.compare("0011"))
-            s.push_back('3');
-        else if (!tmp.compare("0100"))
-            s.push_back('4');
-        else if (!tmp.compare("0101"))
-            s.push_back('5');
-        else if (!tmp.compare("0110"))
-            s.push_back('6');
-        else if (!tmp.compare("0111"))
-            s.push_back('7');
-        else if (!tmp.compare("1000"))
-            s.push_back('8');
-        else if (!tmp.compare("1001"))
-            s.push_back('9');
-        else if (!tmp.compare("1010"))
-            s.push_back('A');
-        else if (!tmp.compare("1011"))
-            s.push_back('B');
-        else if (!tmp.compare("1100"))
-            s.push_back('C');
-        else if (!tmp.compare("1101"))
-            s.push_back('D');
-        else if (!tmp.compare("1110"))
-            s.push_back('E');
-        else
-            s.push_back('F');
-    }
-    return s;
-}
-
 class assembler
 {
     using Commands = std::vector<std::tuple<unsigned, std::string, CommandType>>;
@@ -298,14 +307,44 @@ class assembler
 private:
     LabelMapType label_map;
     Commands commands;
+    std::unordered_map<std::string, MacroType> macros;
+    AssemblerStatsType stats;
+    StreamStateType stream;
+    bool is_optimize = false;
+    // set by TranslateCommand on an instruction it cannot translate
+    int translate_status = 0;
+    // a label named like a register or a #DEC number, which TranslateOprand
+    // then has to look up like any other operand
+    bool has_operand_like_label = false;
 
-    static std::string TranslatePseudo(std::stringstream &command_stream);
-    std::string TranslateCommand(std::stringstream &command_stream, unsigned int current_address);
+    static void TranslatePseudo(std::stringstream &command_stream, std::vector<uint16_t> &words);
+    uint16_t TranslateCommand(std::stringstream &command_stream, unsigned int current_address);
     std::string TranslateOprand(unsigned int current_address, std::string str, int opcode_length = 3);
     std::string LineLabelSplit(const std::string &line, int current_address);
+    int ReadSourceFile(const std::string &filename, SourceFileType &file);
+    int LoadIncludedFile(const std::string &filename, std::shared_ptr<const SourceFileType> &file);
+    int ExpandFile(const std::string &filename, int depth, std::vector<std::string> &lines);
+    int ExpandLine(const std::string &line, int depth, std::vector<std::string> &lines);
     int firstPass(std::string &input_filename);
+    void optimize();
+    // format `words` into `output` and clear them
+    void EmitWords(std::vector<uint16_t> &words, bool is_hex, std::string &output);
     int secondPass(std::string &output_filename);
+    std::string ForwardLabel(const std::string &opcode, const std::string &command) const;
+    void ResolveWaiting(const std::string &label);
+    int StreamLine(const std::string &line);
+    // write out the resolved words at the front of the window, with
+    // `is_final` everything left is resolved first
+    void FlushStream(std::ostream &output_stream, bool is_final);
+    int StreamLines(const std::string &input_filename, std::istream &input_stream,
+                    std::ostream &output_stream);
+    int assembleStream(const std::string &input_filename, const std::string &output_filename);
 
 public:
+    // Peephole pass between the two scans, see optimize. Not done when
+    // streaming, which never holds the whole program.
+    void enableOptimize(bool is_enabled) { is_optimize = is_enabled; }
     int assemble(std::string &input_filename, std::string &output_filename);
+    int exportLabels(const std::string &label_filename) const;
+    const AssemblerStatsType &GetStats() const { return stats; }
 };
@@ -0,0 +1,73 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : phase timings and counters of the assembler (-t / -j)
+ */
+
+#include "assembler_stats.h"
+
+#include <iomanip>
+
+namespace
+{
+
+double ToMilliseconds(uint64_t nanoseconds)
+{
+    return nanoseconds / 1e6;
+}
+
+} // namespace
+
+void AssemblerStatsType::Dump(std::ostream &out) const
+{
+    out << std::fixed << std::setprecision(3);
+    out << "total            = " << ToMilliseconds(total_time) << " ms" << std::endl;
+    out << "  first pass     = " << ToMilliseconds(first_pass_time) << " ms" << std::endl;
+    out << "    read         = " << ToMilliseconds(read_time) << " ms" << std::endl;
+    out << "    format line  = " << ToMilliseconds(format_time) << " ms" << std::endl;
+    out << "  optimize       = " << ToMilliseconds(optimize_time) << " ms" << std::endl;
+    out << "  second pass    = " << ToMilliseconds(second_pass_time) << " ms" << std::endl;
+    out << "    label lookup = " << ToMilliseconds(label_lookup_time) << " ms" << std::endl;
+    out << "    output       = " << ToMilliseconds(output_time) << " ms" << std::endl;
+    out << "lines            = " << lines << std::endl;
+    out << "words            = " << words << std::endl;
+    out << "labels           = " << labels << std::endl;
+    out << "label lookups    = " << label_lookups << std::endl;
+    out << "label hits       = " << label_hits << std::endl;
+    out << "bytes written    = " << bytes_written << std::endl;
+    out << "includes         = " << includes << " (" << include_cache_hits << " cached)"
+        << std::endl;
+    out << "macro expansions = " << macro_expansions << std::endl;
+    out << "branches chained = " << branches_chained << std::endl;
+    out << "removed words    = " << instructions_removed << std::endl;
+}
+
+void AssemblerStatsType::DumpJson(std::ostream &out, const std::string &filename) const
+{
+    out << "{";
+    if (!filename.empty())
+    {
+        out << "\"file\":\"" << filename << "\",";
+    }
+    out << "\"total_ns\":" << total_time
+        << ",\"read_ns\":" << read_time
+        << ",\"first_pass_ns\":" << first_pass_time
+        << ",\"format_ns\":" << format_time
+        << ",\"optimize_ns\":" << optimize_time
+        << ",\"second_pass_ns\":" << second_pass_time
+        << ",\"label_lookup_ns\":" << label_lookup_time
+        << ",\"output_ns\":" << output_time
+        << ",\"lines\":" << lines
+        << ",\"words\":" << words
+        << ",\"labels\":" << labels
+        << ",\"label_lookups\":" << label_lookups
+        << ",\"label_hits\":" << label_hits
+        << ",\"bytes_written\":" << bytes_written
+        << ",\"includes\":" << includes
+        << ",\"include_cache_hits\":" << include_cache_hits
+        << ",\"macro_expansions\":" << macro_expansions
+        << ",\"branches_chained\":" << branches_chained
+        << ",\"instructions_removed\":" << instructions_removed << "}" << std::endl;
+}
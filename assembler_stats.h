@@ -0,0 +1,83 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : phase timings and counters of the assembler (-t / -j)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+extern bool gIsTimingMode;
+
+static inline void SetTimingMode(bool timing)
+{
+    gIsTimingMode = timing;
+}
+
+// Counters are always kept, they are a few increments per line.
+// Phase times (nanoseconds) are only measured in timing mode, a phase
+// includes the phases listed under it in Dump.
+struct AssemblerStatsType
+{
+    uint64_t total_time = 0;
+    uint64_t read_time = 0;
+    uint64_t first_pass_time = 0;
+    uint64_t format_time = 0;
+    uint64_t optimize_time = 0;
+    uint64_t second_pass_time = 0;
+    uint64_t label_lookup_time = 0;
+    uint64_t output_time = 0;
+
+    uint64_t lines = 0;
+    uint64_t words = 0;
+    uint64_t labels = 0;
+    uint64_t label_lookups = 0;
+    uint64_t label_hits = 0;
+    uint64_t bytes_written = 0;
+    uint64_t includes = 0;
+    uint64_t include_cache_hits = 0;
+    uint64_t macro_expansions = 0;
+    uint64_t branches_chained = 0;
+    uint64_t instructions_removed = 0;
+
+    void Dump(std::ostream &out) const;
+    // one JSON object on a single line, with a "file" member if given
+    void DumpJson(std::ostream &out, const std::string &filename = "") const;
+};
+
+// Adds the time between construction and destruction to `elapsed`,
+// does nothing unless timing mode was on at construction
+class PhaseTimerType
+{
+private:
+    using ClockType = std::chrono::steady_clock;
+
+    uint64_t *elapsed_;
+    ClockType::time_point begin_;
+
+public:
+    explicit PhaseTimerType(uint64_t &elapsed) : elapsed_(gIsTimingMode ? &elapsed : nullptr)
+    {
+        if (elapsed_ != nullptr)
+        {
+            begin_ = ClockType::now();
+        }
+    }
+    ~PhaseTimerType()
+    {
+        if (elapsed_ != nullptr)
+        {
+            *elapsed_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             ClockType::now() - begin_)
+                             .count();
+        }
+    }
+    PhaseTimerType(const PhaseTimerType &) = delete;
+    PhaseTimerType &operator=(const PhaseTimerType &) = delete;
+};
@@ -0,0 +1,304 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : Generates the .asm corpora used by bench_runner
+ */
+
+#include "assembler.h"
+#include "cmdline.h"
+
+#include <random>
+#include <sys/stat.h>
+
+// words of one corpus file, leaves room above x3000
+const int kMaxCorpusWords = 50000;
+// labels are only referenced this far away, so PC offsets stay in range
+const int kMaxLabelDistance = 200;
+
+static std::mt19937 gRandom;
+
+static int randomInt(int low, int high) {
+    return std::uniform_int_distribution<int>(low, high)(gRandom);
+}
+
+static std::string randomRegister() {
+    return "R" + std::to_string(randomInt(0, 7));
+}
+
+static std::string randomImmediate(int bit_count) {
+    return "#" + std::to_string(randomInt(-(1 << (bit_count - 1)), (1 << (bit_count - 1)) - 1));
+}
+
+// One instruction `name` with valid operands, `label` is used for the
+// PC relative ones
+static std::string makeInstruction(const std::string &name, const std::string &label) {
+    if (name == "ADD" || name == "AND") {
+        auto third = randomInt(0, 1) ? randomRegister() : randomImmediate(5);
+        return name + " " + randomRegister() + ", " + randomRegister() + ", " + third;
+    }
+    if (name.compare(0, 2, "BR") == 0 || name == "JSR") {
+        return name + " " + label;
+    }
+    if (name == "JMP" || name == "JSRR") {
+        return name + " " + randomRegister();
+    }
+    if (name == "LD" || name == "LDI" || name == "LEA" || name == "ST" || name == "STI") {
+        return name + " " + randomRegister() + ", " + label;
+    }
+    if (name == "LDR" || name == "STR") {
+        return name + " " + randomRegister() + ", " + randomRegister() + ", " + randomImmediate(6);
+    }
+    if (name == "NOT") {
+        return name + " " + randomRegister() + ", " + randomRegister();
+    }
+    if (name == "TRAP") {
+        return "TRAP x2" + std::to_string(randomInt(0, 5));
+    }
+    // RET, RTI
+    return name;
+}
+
+static bool writeCorpus(const std::string &filename, const std::string &body) {
+    std::ofstream file(filename);
+    file << "        .ORIG x3000\n" << body << "        .END\n";
+    return bool(file);
+}
+
+// Every line labeled, references go backwards
+static std::string makeLabelsCorpus(int line_count) {
+    std::string body;
+    for (int i = 0; i < line_count; ++i) {
+        auto name = kLC3Commands[randomInt(0, kLC3Commands.size() - 1)];
+        auto label = "L" + std::to_string(std::max(0, i - randomInt(0, kMaxLabelDistance)));
+        body += "L" + std::to_string(i) + " " + makeInstruction(name, label) + "\n";
+    }
+    return body;
+}
+
+// Every line labeled, references go forwards so none of them can be
+// resolved before the first pass is over
+static std::string makeForwardCorpus(int line_count) {
+    std::string body;
+    for (int i = 0; i < line_count; ++i) {
+        auto name = kLC3Commands[randomInt(0, kLC3Commands.size() - 1)];
+        auto target = std::min(line_count - 1, i + randomInt(1, kMaxLabelDistance));
+        body += "F" + std::to_string(i) + " " + makeInstruction(name, "F" + std::to_string(target)) +
+                "\n";
+    }
+    return body;
+}
+
+// Few lines, many words: .BLKW and .STRINGZ blocks with a .FILL between them
+static std::string makeBlocksCorpus(int word_count) {
+    std::string body;
+    int words = 0;
+    for (int i = 0; words < word_count; ++i) {
+        if (i % 2 == 0) {
+            int size = randomInt(100, 2000);
+            body += "B" + std::to_string(i) + " .BLKW #" + std::to_string(size) + "\n";
+            words += size;
+        } else {
+            // upper case letters only, the assembler upper-cases the line
+            int size = randomInt(10, 200);
+            std::string text;
+            for (int j = 0; j < size; ++j) {
+                text.push_back('A' + randomInt(0, 25));
+            }
+            body += "S" + std::to_string(i) + " .STRINGZ \"" + text + "\"\n";
+            words += size + 1;
+        }
+        body += "        .FILL #" + std::to_string(randomInt(-32768, 32767)) + "\n";
+        ++words;
+    }
+    return body;
+}
+
+// Every opcode in kLC3Commands and every trap routine, in turn
+static std::string makeOpcodesCorpus(int line_count) {
+    const int kLabelInterval = 8;
+    std::string body;
+    for (int i = 0; i < line_count; ++i) {
+        int index = i % (kLC3Commands.size() + kLC3TrapRoutine.size());
+        int labeled_line = i / kLabelInterval * kLabelInterval;
+        auto label = "O" + std::to_string(labeled_line);
+        std::string line = i % kLabelInterval == 0 ? label : "";
+        line.resize(8, ' ');
+        if (index < int(kLC3Commands.size())) {
+            line += makeInstruction(kLC3Commands[index], label);
+        } else {
+            line += kLC3TrapRoutine[index - kLC3Commands.size()];
+        }
+        body += line + "\n";
+    }
+    return body;
+}
+
+// A loop for the simulator, about `outer_count` * `inner_count` * 8 instructions
+static std::string makeLoopKernel(int outer_count, int inner_count) {
+    return "        LD R1, OUTER_N\n"
+           "OUTER   LD R2, INNER_N\n"
+           "INNER   ADD R3, R3, #1\n"
+           "        AND R4, R3, #15\n"
+           "        LEA R5, BUF\n"
+           "        STR R4, R5, #0\n"
+           "        LDR R6, R5, #0\n"
+           "        NOT R6, R6\n"
+           "        ADD R2, R2, #-1\n"
+           "        BRP INNER\n"
+           "        ADD R1, R1, #-1\n"
+           "        BRP OUTER\n"
+           "        HALT\n"
+           "OUTER_N .FILL #" + std::to_string(outer_count) + "\n"
+           "INNER_N .FILL #" + std::to_string(inner_count) + "\n"
+           "BUF     .BLKW #1\n";
+}
+
+// Rewrites the halves of a fused pair, `count` times: the second one
+// (W) on every iteration, the first one (W - 1) on every other one, so a
+// predecoded entry for W - 1 left stale by a write to W changes R4
+static std::string makeSelfModifyingKernel(int count) {
+    return "        LD R1, COUNT\n"
+           "PAIR    AND R2, R2, #0\n"
+           "PAIR2   ADD R2, R2, #1\n"
+           "        ADD R4, R4, R2\n"
+           "        AND R5, R1, #1\n"
+           "        BRZ EVEN\n"
+           "        LD R6, ALT2\n"
+           "        ST R6, PAIR2\n"
+           "        BRNZP FIRST\n"
+           "EVEN    LD R6, ORIG2\n"
+           "        ST R6, PAIR2\n"
+           "FIRST   AND R5, R1, #3\n"
+           "        BRZ RESET\n"
+           "        ADD R5, R5, #-2\n"
+           "        BRNP NEXT\n"
+           "        LD R6, ALT1\n"
+           "        ST R6, PAIR\n"
+           "        BRNZP NEXT\n"
+           "RESET   LD R6, ORIG1\n"
+           "        ST R6, PAIR\n"
+           "NEXT    ADD R1, R1, #-1\n"
+           "        BRP PAIR\n"
+           "        HALT\n"
+           "ORIG1   AND R2, R2, #0\n"
+           "ORIG2   ADD R2, R2, #1\n"
+           "ALT1    ADD R2, R2, #0\n"
+           "ALT2    ADD R2, R2, #3\n"
+           "COUNT   .FILL #" + std::to_string(count) + "\n";
+}
+
+// Prints `char_count` characters by polling DSR while a timer interrupts
+// every `period` instructions, so the accelerated mode has to stop its
+// skips at the interrupts to count the same as the exact mode
+static std::string makeTimerKernel(int char_count, int period) {
+    return "        LD R0, THANDLER\n"
+           "        STI R0, TVEC\n"
+           "        LD R0, PERIOD\n"
+           "        STI R0, TMR\n"
+           "        LD R0, IE\n"
+           "        STI R0, TSR\n"
+           "        LD R1, CHAR_N\n"
+           "POLL    LDI R2, DSR\n"
+           "        BRZP POLL\n"
+           "        LD R0, CHAR\n"
+           "        STI R0, DDR\n"
+           "        ADD R1, R1, #-1\n"
+           "        BRP POLL\n"
+           "        HALT\n"
+           // x300E
+           "TICK    ADD R5, R5, #1\n"
+           "        RTI\n"
+           "THANDLER .FILL x300E\n"
+           "TVEC    .FILL x0181\n"
+           "TMR     .FILL xFE0A\n"
+           "TSR     .FILL xFE08\n"
+           "DSR     .FILL xFE04\n"
+           "DDR     .FILL xFE06\n"
+           "IE      .FILL x4000\n"
+           "CHAR    .FILL x2A\n"
+           "PERIOD  .FILL #" + std::to_string(period) + "\n"
+           "CHAR_N  .FILL #" + std::to_string(char_count) + "\n";
+}
+
+int main(int argc, char **argv) {
+    if (cmdOptionExists(argv, argv + argc, "-h")) {
+        std::cout << "This generates benchmark corpora for the LC-3 tools." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mUsage\e[0m" << std::endl;
+        std::cout << "./bench_generator \e[1m[OPTION]\e[0m ..." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mOptions\e[0m" << std::endl;
+        std::cout << "-h : print out help information" << std::endl;
+        std::cout << "-o : the output directory (default bench_data)" << std::endl;
+        std::cout << "-n : lines of each large corpus (default 40000)" << std::endl;
+        std::cout << "-m : number of small files (default 200)" << std::endl;
+        std::cout << "-i : outer iterations of the simulator loop (default 2000)" << std::endl;
+        std::cout << "-r : random seed (default 1)" << std::endl;
+        return 0;
+    }
+
+    auto directory_info = getCmdOption(argv, argv + argc, "-o");
+    std::string directory = directory_info.first ? directory_info.second : "bench_data";
+    // a count option, -1 when it is given but not a number
+    auto countOption = [&](const std::string &option, long default_count) {
+        auto info = getCmdOption(argv, argv + argc, option);
+        return info.first ? parseCount(info.second) : default_count;
+    };
+    auto line_count = countOption("-n", 40000);
+    auto small_file_count = countOption("-m", 200);
+    auto outer_count = countOption("-i", 2000);
+    auto seed = countOption("-r", 1);
+    if (line_count < 0 || small_file_count < 0 || outer_count < 0 || seed < 0) {
+        std::cout << "Invalid count for -n, -m, -i or -r" << std::endl;
+        return -1;
+    }
+    line_count = std::max(1L, std::min<long>(line_count, kMaxCorpusWords));
+    // counters are compared with BRP, keep them positive
+    outer_count = std::max(1L, std::min(outer_count, 0x7FFFL));
+    gRandom.seed(seed);
+
+    mkdir(directory.c_str(), 0755);
+    directory += "/";
+
+    // * Manifest:
+    // * One corpus per line, "asm NAME FILE..." for the assembler only,
+    // * "sim NAME FILE" for a program also run by the simulator
+    std::ofstream manifest(directory + "manifest.txt");
+    if (!manifest) {
+        std::cout << "Unable to create " << directory << "manifest.txt" << std::endl;
+        return -1;
+    }
+    bool is_ok = true;
+    is_ok &= writeCorpus(directory + "labels.asm", makeLabelsCorpus(line_count));
+    manifest << "asm labels labels.asm" << std::endl;
+    is_ok &= writeCorpus(directory + "forward.asm", makeForwardCorpus(line_count));
+    manifest << "asm forward forward.asm" << std::endl;
+    is_ok &= writeCorpus(directory + "blocks.asm", makeBlocksCorpus(kMaxCorpusWords));
+    manifest << "asm blocks blocks.asm" << std::endl;
+    is_ok &= writeCorpus(directory + "opcodes.asm", makeOpcodesCorpus(line_count));
+    manifest << "asm opcodes opcodes.asm" << std::endl;
+
+    const int kSmallFileLines = 50;
+    manifest << "asm small";
+    for (int i = 0; i < small_file_count; ++i) {
+        auto filename = "small_" + std::to_string(i) + ".asm";
+        is_ok &= writeCorpus(directory + filename, makeOpcodesCorpus(kSmallFileLines));
+        manifest << " " << filename;
+    }
+    manifest << std::endl;
+
+    is_ok &= writeCorpus(directory + "loop.asm", makeLoopKernel(outer_count, 1000));
+    manifest << "sim loop loop.asm" << std::endl;
+    is_ok &= writeCorpus(directory + "timer.asm", makeTimerKernel(2000, 7));
+    manifest << "sim timer timer.asm" << std::endl;
+    is_ok &= writeCorpus(directory + "selfmod.asm", makeSelfModifyingKernel(outer_count));
+    manifest << "sim selfmod selfmod.asm" << std::endl;
+
+    if (!is_ok) {
+        std::cout << "Unable to write the corpora" << std::endl;
+        return -1;
+    }
+    return 0;
+}
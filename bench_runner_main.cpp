@@ -0,0 +1,276 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : Runs the tools over the bench_generator corpora, writes CSV
+ */
+
+#include "cmdline.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+struct RunResultType {
+    int status = -1;
+    std::string output;
+    double seconds = 0;
+    long peak_rss_kb = 0;
+};
+
+// Run `arguments` in a child process, collect its stdout, wall time and
+// peak resident set size
+static RunResultType runCommand(const std::vector<std::string> &arguments) {
+    RunResultType result;
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        return result;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        return result;
+    }
+    if (pid == 0) {
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        std::vector<char *> argv;
+        for (const auto &argument : arguments) {
+            argv.push_back(const_cast<char *>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(pipe_fds[1]);
+    char buffer[4096];
+    ssize_t size;
+    while ((size = read(pipe_fds[0], buffer, sizeof(buffer))) > 0) {
+        result.output.append(buffer, size);
+    }
+    close(pipe_fds[0]);
+
+    int status = 0;
+    struct rusage usage {};
+    wait4(pid, &status, 0, &usage);
+    result.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    result.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    // kilobytes on Linux
+    result.peak_rss_kb = usage.ru_maxrss;
+    return result;
+}
+
+// Value of `"key":number` in the assembler -j output, 0 if missing
+static double jsonNumber(const std::string &json, const std::string &key) {
+    auto position = json.find("\"" + key + "\":");
+    if (position == std::string::npos) {
+        return 0;
+    }
+    return std::stod(json.substr(position + key.size() + 3));
+}
+
+static double perSecond(double count, double nanoseconds) {
+    return nanoseconds == 0 ? 0 : count / (nanoseconds / 1e9);
+}
+
+// Sum of the assembler counters over the files of one corpus
+struct AssembleTotalsType {
+    double lines = 0;
+    double words = 0;
+    double label_lookups = 0;
+    double total_ns = 0;
+    double read_ns = 0;
+    double first_pass_ns = 0;
+    double format_ns = 0;
+    double second_pass_ns = 0;
+    double label_lookup_ns = 0;
+    double output_ns = 0;
+    long peak_rss_kb = 0;
+
+    void Add(const RunResultType &run) {
+        const auto &json = run.output;
+        lines += jsonNumber(json, "lines");
+        words += jsonNumber(json, "words");
+        label_lookups += jsonNumber(json, "label_lookups");
+        total_ns += jsonNumber(json, "total_ns");
+        read_ns += jsonNumber(json, "read_ns");
+        first_pass_ns += jsonNumber(json, "first_pass_ns");
+        format_ns += jsonNumber(json, "format_ns");
+        second_pass_ns += jsonNumber(json, "second_pass_ns");
+        label_lookup_ns += jsonNumber(json, "label_lookup_ns");
+        output_ns += jsonNumber(json, "output_ns");
+        peak_rss_kb = std::max(peak_rss_kb, run.peak_rss_kb);
+    }
+};
+
+// `text` without the line starting with `prefix`
+static std::string withoutLine(const std::string &text, const std::string &prefix) {
+    auto begin = text.find("\n" + prefix);
+    if (begin == std::string::npos) {
+        return text;
+    }
+    auto end = text.find('\n', begin + 1);
+    return text.substr(0, begin) + (end == std::string::npos ? "" : text.substr(end));
+}
+
+// `text` up to the first line starting with `prefix`
+static std::string beforeLine(const std::string &text, const std::string &prefix) {
+    auto end = text.find("\n" + prefix);
+    return end == std::string::npos ? text : text.substr(0, end + 1);
+}
+
+static void writeRow(std::ostream &out, const std::string &corpus, const std::string &metric,
+                     double value) {
+    out << corpus << "," << metric << "," << std::setprecision(12) << value << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (cmdOptionExists(argv, argv + argc, "-h")) {
+        std::cout << "This runs the LC-3 tools over generated corpora." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mUsage\e[0m" << std::endl;
+        std::cout << "./bench_runner \e[1m[OPTION]\e[0m ..." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mOptions\e[0m" << std::endl;
+        std::cout << "-h : print out help information" << std::endl;
+        std::cout << "-d : the corpus directory (default bench_data)" << std::endl;
+        std::cout << "-o : the path for the CSV file (default stdout)" << std::endl;
+        std::cout << "-r : runs per corpus, the fastest one is kept (default 3)" << std::endl;
+        std::cout << "-a : the assembler binary (default ./assembler)" << std::endl;
+        std::cout << "-s : the simulator binary (default ./simulator)" << std::endl;
+        return 0;
+    }
+
+    auto directory_info = getCmdOption(argv, argv + argc, "-d");
+    std::string directory = (directory_info.first ? directory_info.second : "bench_data") + "/";
+    auto repeat_info = getCmdOption(argv, argv + argc, "-r");
+    long repeat_count = repeat_info.first ? parseCount(repeat_info.second) : 3;
+    if (repeat_count < 0) {
+        std::cout << "Invalid run count" << std::endl;
+        return -1;
+    }
+    repeat_count = std::max(1L, repeat_count);
+    auto assembler_info = getCmdOption(argv, argv + argc, "-a");
+    std::string assembler_path = assembler_info.first ? assembler_info.second : "./assembler";
+    auto simulator_info = getCmdOption(argv, argv + argc, "-s");
+    std::string simulator_path = simulator_info.first ? simulator_info.second : "./simulator";
+
+    std::ifstream manifest(directory + "manifest.txt");
+    if (!manifest) {
+        std::cout << "Unable to open " << directory << "manifest.txt, run bench_generator first"
+                  << std::endl;
+        return -1;
+    }
+
+    auto output_info = getCmdOption(argv, argv + argc, "-o");
+    std::ofstream output_file;
+    if (output_info.first) {
+        output_file.open(output_info.second);
+        if (!output_file) {
+            std::cout << "Unable to open output file" << std::endl;
+            return -1;
+        }
+    }
+    std::ostream &out = output_info.first ? output_file : std::cout;
+    out << "corpus,metric,value" << std::endl;
+
+    std::string line;
+    while (std::getline(manifest, line)) {
+        std::stringstream line_stream(line);
+        std::string kind, corpus, filename;
+        line_stream >> kind >> corpus;
+        std::vector<std::string> filenames;
+        while (line_stream >> filename) {
+            filenames.push_back(directory + filename);
+        }
+
+        AssembleTotalsType best;
+        for (int repeat = 0; repeat < repeat_count; ++repeat) {
+            AssembleTotalsType totals;
+            for (const auto &asm_filename : filenames) {
+                auto image_filename = asm_filename.substr(0, asm_filename.rfind('.')) + ".bin";
+                auto run = runCommand({assembler_path, "-f", asm_filename, "-o", image_filename, "-j"});
+                if (run.status != 0) {
+                    std::cout << "Assembler failed on " << asm_filename << std::endl;
+                    return -1;
+                }
+                totals.Add(run);
+            }
+            if (repeat == 0 || totals.total_ns < best.total_ns) {
+                best = totals;
+            }
+        }
+
+        writeRow(out, corpus, "files", filenames.size());
+        writeRow(out, corpus, "lines", best.lines);
+        writeRow(out, corpus, "words", best.words);
+        writeRow(out, corpus, "total_ms", best.total_ns / 1e6);
+        writeRow(out, corpus, "lines_per_sec", perSecond(best.lines, best.total_ns));
+        writeRow(out, corpus, "words_per_sec", perSecond(best.words, best.total_ns));
+        writeRow(out, corpus, "read_lines_per_sec", perSecond(best.lines, best.read_ns));
+        writeRow(out, corpus, "first_pass_lines_per_sec", perSecond(best.lines, best.first_pass_ns));
+        writeRow(out, corpus, "format_lines_per_sec", perSecond(best.lines, best.format_ns));
+        writeRow(out, corpus, "second_pass_words_per_sec", perSecond(best.words, best.second_pass_ns));
+        writeRow(out, corpus, "label_lookups_per_sec",
+                 perSecond(best.label_lookups, best.label_lookup_ns));
+        writeRow(out, corpus, "output_words_per_sec", perSecond(best.words, best.output_ns));
+        writeRow(out, corpus, "assembler_peak_rss_kb", best.peak_rss_kb);
+
+        if (kind != "sim") {
+            continue;
+        }
+        // * Simulator:
+        // * Instruction count from -e, time is the whole process, so the
+        // * loop has to be long enough for loading to not matter
+        auto image_filename = filenames[0].substr(0, filenames[0].rfind('.')) + ".bin";
+        RunResultType best_run;
+        for (int repeat = 0; repeat < repeat_count; ++repeat) {
+            auto run = runCommand({simulator_path, "-f", image_filename, "-e"});
+            if (run.status != 0) {
+                std::cout << "Simulator failed on " << image_filename << std::endl;
+                return -1;
+            }
+            if (repeat == 0 || run.seconds < best_run.seconds) {
+                best_run = run;
+            }
+        }
+        // * Accelerated mode:
+        // * Has to count exactly the same, only "executed" may differ
+        auto accelerated_run = runCommand({simulator_path, "-f", image_filename, "-e", "-a"});
+        if (withoutLine(accelerated_run.output, "executed = ") != best_run.output) {
+            std::cout << "Accelerated mode differs on " << image_filename << std::endl;
+            return -1;
+        }
+        // * Fused pairs:
+        // * Only the plain loop fuses, -s runs every instruction alone; its
+        // * registers and count, up to the blank line before the stats,
+        // * have to be the same
+        auto unfused_run = runCommand({simulator_path, "-f", image_filename, "-e", "-s"});
+        if (beforeLine(unfused_run.output, "cycles ") != best_run.output + "\n") {
+            std::cout << "Fused execution differs on " << image_filename << std::endl;
+            return -1;
+        }
+
+        auto position = best_run.output.find("instructions = ");
+        double instructions =
+            position == std::string::npos ? 0 : std::stod(best_run.output.substr(position + 15));
+        writeRow(out, corpus, "instructions", instructions);
+        writeRow(out, corpus, "simulator_ms", best_run.seconds * 1e3);
+        writeRow(out, corpus, "instructions_per_sec",
+                 best_run.seconds == 0 ? 0 : instructions / best_run.seconds);
+        writeRow(out, corpus, "simulator_peak_rss_kb", best_run.peak_rss_kb);
+    }
+    return 0;
+}
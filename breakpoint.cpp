@@ -0,0 +1,57 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for breakpoints and watchpoints
+ */
+
+#include "breakpoint.h"
+
+void BreakpointMapType::Add(uint16_t address, uint8_t kind)
+{
+    if (flags_[address] == 0)
+    {
+        ++count_;
+    }
+    flags_[address] |= kind;
+    pages_.set(address >> kPageBits);
+}
+
+void BreakpointMapType::Remove(uint16_t address, uint8_t kind)
+{
+    if (flags_[address] == 0)
+    {
+        return;
+    }
+    flags_[address] &= ~kind;
+    if (flags_[address] != 0)
+    {
+        return;
+    }
+    --count_;
+
+    // clear the page bit once nothing is left in the page
+    uint16_t page_begin = address & ~((1 << kPageBits) - 1);
+    for (int offset = 0; offset < (1 << kPageBits); ++offset)
+    {
+        if (flags_[page_begin + offset] != 0)
+        {
+            return;
+        }
+    }
+    pages_.reset(address >> kPageBits);
+}
+
+std::vector<uint16_t> BreakpointMapType::GetAddresses() const
+{
+    std::vector<uint16_t> addresses;
+    for (int address = 0; address < int(flags_.size()); ++address)
+    {
+        if (flags_[address] != 0)
+        {
+            addresses.push_back(address);
+        }
+    }
+    return addresses;
+}
@@ -0,0 +1,41 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : breakpoints and watchpoints of the simulator
+ */
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+const uint8_t kBreakpoint = 1;
+const uint8_t kWatchRead = 2;
+const uint8_t kWatchWrite = 4;
+
+// Breakpoints and watchpoints by address.
+// A bitmap with one bit per 256-word page tells whether the page holds
+// any of them, so the checked loop only looks up the exact address for
+// the few pages that do.
+class BreakpointMapType
+{
+private:
+    static const int kPageBits = 8;
+    static const int kPageCount = 65536 >> kPageBits;
+
+    std::bitset<kPageCount> pages_;
+    std::vector<uint8_t> flags_ = std::vector<uint8_t>(65536);
+    int count_ = 0;
+
+public:
+    void Add(uint16_t address, uint8_t kind);
+    void Remove(uint16_t address, uint8_t kind);
+    bool Empty() const { return count_ == 0; }
+    bool IsPageMarked(uint16_t address) const { return pages_.test(address >> kPageBits); }
+    uint8_t GetFlags(uint16_t address) const { return flags_[address]; }
+    // addresses holding any point, in order
+    std::vector<uint16_t> GetAddresses() const;
+};
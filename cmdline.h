@@ -0,0 +1,65 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : command line helpers shared by the tools
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+// A simple arguments parser
+static inline std::pair<bool, std::string> getCmdOption(char **begin, char **end,
+                                                        const std::string &option) {
+    char **itr = std::find(begin, end, option);
+    if (itr != end && ++itr != end) {
+        return std::make_pair(true, *itr);
+    }
+    return std::make_pair(false, "");
+}
+
+static inline bool cmdOptionExists(char **begin, char **end, const std::string &option) {
+    return std::find(begin, end, option) != end;
+}
+
+// Parse an address written as "x3000", "0x3000" or "3000" (always hex),
+// -1 unless the whole string is one
+static inline int parseAddress(const std::string &str) {
+    std::string digits = str;
+    if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+        digits = digits.substr(2);
+    } else if (!digits.empty() && (digits[0] == 'x' || digits[0] == 'X')) {
+        digits = digits.substr(1);
+    }
+    if (digits.empty() || !isxdigit(static_cast<unsigned char>(digits[0]))) {
+        return -1;
+    }
+    char *end;
+    errno = 0;
+    auto value = strtol(digits.c_str(), &end, 16);
+    if (*end != '\0' || errno == ERANGE) {
+        return -1;
+    }
+    return int(value & 0xFFFF);
+}
+
+// Parse a decimal count, -1 unless the whole string is a number >= 0
+static inline long parseCount(const std::string &str) {
+    if (str.empty() || !isdigit(static_cast<unsigned char>(str[0]))) {
+        return -1;
+    }
+    char *end;
+    errno = 0;
+    auto value = strtol(str.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE) {
+        return -1;
+    }
+    return value;
+}
@@ -0,0 +1,231 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for command line debugger of the simulator
+ */
+
+#include "debugger.h"
+#include "cmdline.h"
+#include "disassembler.h"
+
+#include <algorithm>
+#include <sstream>
+
+const char *kDebuggerHelp =
+    "break/b LOC       stop before the instruction at LOC\n"
+    "watch LOC         stop after LOC is written\n"
+    "rwatch LOC        stop after LOC is read\n"
+    "awatch LOC        stop after LOC is read or written\n"
+    "delete/d LOC      remove every point at LOC\n"
+    "info/i            list breakpoints and watchpoints\n"
+    "continue/c        run until HALT or a point is hit\n"
+    "step/s [N]        execute N instructions (default 1)\n"
+    "regs/r            print out registers\n"
+    "mem/x LOC [N]     print out N words from LOC (default 1)\n"
+    "quit/q            leave the debugger\n"
+    "LOC is a label from the label table or a hex address like x3000\n";
+
+debugger::debugger(simulator &sim, const SymbolTableType &symbols)
+    : sim(sim), symbols(symbols)
+{
+}
+
+int debugger::ParseLocation(std::string str) const
+{
+    std::transform(str.begin(), str.end(), str.begin(), ::toupper);
+    // labels first, "ABC" could be both
+    auto address = symbols.GetAddress(str);
+    if (address != -1)
+    {
+        return address;
+    }
+    return parseAddress(str);
+}
+
+void debugger::PrintLocation(std::ostream &out, uint16_t address) const
+{
+    out << FormatAddress(address) << " <" << symbols.Symbolize(address) << ">  "
+        << DisassembleInstruction(sim.ReadMemory(address), address, symbols) << std::endl;
+}
+
+void debugger::PrintStop(std::ostream &out, int status) const
+{
+    switch (status)
+    {
+    case SimulatorStatus::HALTED:
+        out << "Halted after " << sim.GetInstructionCount() << " instructions" << std::endl;
+        return;
+    case SimulatorStatus::BREAKPOINT:
+        out << "Breakpoint at ";
+        break;
+    case SimulatorStatus::WATCHPOINT:
+        out << (sim.IsWatchHitWrite() ? "Write to " : "Read from ")
+            << symbols.Symbolize(sim.GetWatchHitAddress()) << " = "
+            << FormatAddress(sim.ReadMemory(sim.GetWatchHitAddress())) << ", next ";
+        break;
+    case SimulatorStatus::STEP_LIMIT:
+        break;
+    default:
+        out << "Stopped with error " << status << " at ";
+        break;
+    }
+    PrintLocation(out, sim.GetRegisters().pc);
+}
+
+void debugger::PrintRegisters(std::ostream &out) const
+{
+    const auto &registers = sim.GetRegisters();
+    for (int i = 0; i < kLC3RegisterCount; ++i)
+    {
+        out << "R" << i << " = " << FormatAddress(registers.r[i])
+            << ((i % 4 == 3) ? "\n" : "  ");
+    }
+    out << "PC = " << FormatAddress(registers.pc) << "  PSR = " << FormatAddress(registers.psr)
+        << "  CC = " << ((registers.psr & kLC3ConditionN) ? "N" : "")
+        << ((registers.psr & kLC3ConditionZ) ? "Z" : "")
+        << ((registers.psr & kLC3ConditionP) ? "P" : "") << std::endl;
+}
+
+void debugger::PrintPoints(std::ostream &out) const
+{
+    auto &breakpoints = sim.GetBreakpoints();
+    for (auto address : breakpoints.GetAddresses())
+    {
+        auto flags = breakpoints.GetFlags(address);
+        out << FormatAddress(address) << " <" << symbols.Symbolize(address) << ">";
+        if (flags & kBreakpoint)
+            out << " break";
+        if (flags & kWatchRead)
+            out << " read";
+        if (flags & kWatchWrite)
+            out << " write";
+        out << std::endl;
+    }
+}
+
+int debugger::loop(std::istream &in, std::ostream &out)
+{
+    auto &breakpoints = sim.GetBreakpoints();
+    std::string line;
+    PrintLocation(out, sim.GetRegisters().pc);
+    out << "(lc3db) " << std::flush;
+    while (std::getline(in, line))
+    {
+        std::stringstream line_stream(line);
+        std::string command;
+        std::string argument;
+        line_stream >> command >> argument;
+
+        if (command.empty())
+        {
+            // nothing to do
+        }
+        else if (command == "quit" || command == "q")
+        {
+            break;
+        }
+        else if (command == "help" || command == "h")
+        {
+            out << kDebuggerHelp;
+        }
+        else if (command == "break" || command == "b" || command == "watch" ||
+                 command == "rwatch" || command == "awatch" || command == "delete" ||
+                 command == "d")
+        {
+            auto address = ParseLocation(argument);
+            if (address < 0)
+            {
+                out << "Unknown location: " << argument << std::endl;
+            }
+            else if (command == "break" || command == "b")
+            {
+                breakpoints.Add(address, kBreakpoint);
+            }
+            else if (command == "watch")
+            {
+                breakpoints.Add(address, kWatchWrite);
+            }
+            else if (command == "rwatch")
+            {
+                breakpoints.Add(address, kWatchRead);
+            }
+            else if (command == "awatch")
+            {
+                breakpoints.Add(address, kWatchRead | kWatchWrite);
+            }
+            else
+            {
+                breakpoints.Remove(address, kBreakpoint | kWatchRead | kWatchWrite);
+            }
+        }
+        else if (command == "info" || command == "i")
+        {
+            PrintPoints(out);
+        }
+        else if (command == "continue" || command == "c")
+        {
+            PrintStop(out, sim.run(0));
+        }
+        else if (command == "step" || command == "s")
+        {
+            long count = argument.empty() ? 1 : parseCount(argument);
+            if (count < 0)
+            {
+                out << "Usage: step [N]" << std::endl;
+            }
+            else
+            {
+                int status = SimulatorStatus::STEP_LIMIT;
+                for (long i = 0; i < count && !sim.IsHalted(); ++i)
+                {
+                    status = sim.step();
+                    if (status == 0 && sim.IsWatchHit())
+                    {
+                        status = SimulatorStatus::WATCHPOINT;
+                    }
+                    if (status != 0)
+                    {
+                        break;
+                    }
+                    status = SimulatorStatus::STEP_LIMIT;
+                }
+                PrintStop(out, sim.IsHalted() ? int(SimulatorStatus::HALTED) : status);
+            }
+        }
+        else if (command == "regs" || command == "r")
+        {
+            PrintRegisters(out);
+        }
+        else if (command == "mem" || command == "x")
+        {
+            auto address = ParseLocation(argument);
+            std::string count_argument;
+            line_stream >> count_argument;
+            long count = count_argument.empty() ? 1 : parseCount(count_argument);
+            if (count < 0)
+            {
+                out << "Usage: mem LOC [N]" << std::endl;
+                count = 0;
+            }
+            else if (address < 0)
+            {
+                out << "Unknown location: " << argument << std::endl;
+            }
+            for (long i = 0; address >= 0 && i < count; ++i)
+            {
+                uint16_t current = address + i;
+                out << FormatAddress(current) << "  " << FormatAddress(sim.ReadMemory(current))
+                    << "  " << DisassembleInstruction(sim.ReadMemory(current), current, symbols)
+                    << std::endl;
+            }
+        }
+        else
+        {
+            out << "Unknown command, try help" << std::endl;
+        }
+        out << "(lc3db) " << std::flush;
+    }
+    return 0;
+}
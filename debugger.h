@@ -0,0 +1,35 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : header file for command line debugger of the simulator
+ */
+
+#pragma once
+
+#include "simulator.h"
+#include "symbol.h"
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+class debugger
+{
+private:
+    simulator &sim;
+    const SymbolTableType &symbols;
+
+    // label or hex address, -1 if neither
+    int ParseLocation(std::string str) const;
+    void PrintLocation(std::ostream &out, uint16_t address) const;
+    void PrintStop(std::ostream &out, int status) const;
+    void PrintRegisters(std::ostream &out) const;
+    void PrintPoints(std::ostream &out) const;
+
+public:
+    debugger(simulator &sim, const SymbolTableType &symbols);
+    // Read commands from `in` until quit or EOF
+    int loop(std::istream &in, std::ostream &out);
+};
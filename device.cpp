@@ -0,0 +1,281 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for memory-mapped console and timer devices
+ */
+
+#include "device.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+
+size_t StreamBackendType::Read(char *buffer, size_t size)
+{
+    auto ch = in_->get();
+    if (ch == std::char_traits<char>::eof() || size == 0)
+    {
+        return 0;
+    }
+    buffer[0] = char(ch);
+    return 1;
+}
+
+void StreamBackendType::Write(const char *data, size_t size)
+{
+    out_->write(data, size);
+    out_->flush();
+}
+
+size_t PipeBackendType::Read(char *buffer, size_t size)
+{
+    ssize_t count;
+    do
+    {
+        count = read(in_fd_, buffer, size);
+    } while (count < 0 && errno == EINTR);
+    return count < 0 ? 0 : size_t(count);
+}
+
+bool PipeBackendType::IsReadReady()
+{
+    // readable, at the end of the input, or broken: none of them waits
+    struct pollfd poll_fd = {in_fd_, POLLIN, 0};
+    return poll(&poll_fd, 1, 0) != 0;
+}
+
+void PipeBackendType::Write(const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        auto count = write(out_fd_, data, size);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            // the reader is gone, nothing more can be written
+            return;
+        }
+        data += count;
+        size -= count;
+    }
+}
+
+FileBackendType::~FileBackendType()
+{
+    if (in_fd_ >= 0)
+    {
+        close(in_fd_);
+    }
+    if (out_fd_ != STDOUT_FILENO)
+    {
+        close(out_fd_);
+    }
+}
+
+int FileBackendType::Open(const std::string &input_filename, const std::string &output_filename)
+{
+    in_fd_ = open(input_filename.c_str(), O_RDONLY);
+    if (in_fd_ < 0)
+    {
+        // @ Error at input file
+        return -1;
+    }
+    if (!output_filename.empty())
+    {
+        out_fd_ = open(output_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out_fd_ < 0)
+        {
+            out_fd_ = STDOUT_FILENO;
+            // @ Error at output file
+            return -2;
+        }
+    }
+    return 0;
+}
+
+size_t MemoryBackendType::Read(char *buffer, size_t size)
+{
+    auto count = std::min(size, input_.size() - input_position_);
+    input_.copy(buffer, count, input_position_);
+    input_position_ += count;
+    return count;
+}
+
+void MemoryBackendType::Write(const char *data, size_t size)
+{
+    output_.append(data, size);
+}
+
+void ConsoleDeviceType::SetBackend(std::shared_ptr<ConsoleBackendType> backend)
+{
+    Flush();
+    backend_ = std::move(backend);
+    input_begin_ = input_end_ = 0;
+    is_input_end_ = false;
+}
+
+bool ConsoleDeviceType::HasInput()
+{
+    if (input_begin_ < input_end_)
+    {
+        return true;
+    }
+    if (is_input_end_)
+    {
+        return false;
+    }
+    if (!input_buffer_)
+    {
+        input_buffer_ = std::make_unique<char[]>(kConsoleChunkSize);
+    }
+    // the program may be waiting on a prompt it printed
+    Flush();
+    input_begin_ = 0;
+    input_end_ = backend_->Read(input_buffer_.get(), kConsoleChunkSize);
+    is_input_end_ = input_end_ == 0;
+    return !is_input_end_;
+}
+
+uint16_t ConsoleDeviceType::Read(uint16_t address, uint64_t now)
+{
+    switch (address)
+    {
+    case kLC3KBSR:
+        return (now >= ReadyAt(kLC3KBSR) ? kLC3DeviceReady : 0) |
+               (state_.is_keyboard_interrupt ? kLC3InterruptEnable : 0);
+    case kLC3KBDR:
+        if (now >= ReadyAt(kLC3KBSR))
+        {
+            state_.last_key = GetChar();
+            state_.keyboard_ready_at = now + kKeyboardLatency;
+        }
+        return state_.last_key;
+    case kLC3DSR:
+        return now >= state_.display_ready_at ? kLC3DeviceReady : 0;
+    case kLC3TSR:
+    {
+        uint16_t value = state_.is_timer_interrupt ? kLC3InterruptEnable : 0;
+        if (now >= state_.timer_ready_at)
+        {
+            // acknowledged, the next period starts where this one ended
+            value |= kLC3DeviceReady;
+            state_.timer_ready_at = now + state_.timer_period - (now - state_.timer_ready_at) % state_.timer_period;
+        }
+        return value;
+    }
+    case kLC3TMR:
+        return state_.timer_period;
+    case kLC3MCR:
+        return state_.is_running ? 0x8000 : 0;
+    default:
+        return 0;
+    }
+}
+
+void ConsoleDeviceType::Write(uint16_t address, uint16_t value, uint64_t now)
+{
+    switch (address)
+    {
+    case kLC3KBSR:
+        state_.is_keyboard_interrupt = value & kLC3InterruptEnable;
+        break;
+    case kLC3DDR:
+        PutChar(char(value & 0xFF));
+        state_.display_ready_at = now + kDisplayLatency;
+        break;
+    case kLC3TSR:
+        state_.is_timer_interrupt = value & kLC3InterruptEnable;
+        break;
+    case kLC3TMR:
+        state_.timer_period = value;
+        state_.timer_ready_at = value == 0 ? kNever : now + value;
+        break;
+    case kLC3MCR:
+        state_.is_running = value & 0x8000;
+        if (!state_.is_running)
+        {
+            Flush();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+uint64_t ConsoleDeviceType::ReadyAt(uint16_t address)
+{
+    if (address == kLC3DSR)
+    {
+        return state_.display_ready_at;
+    }
+    if (address == kLC3TSR)
+    {
+        return state_.timer_ready_at;
+    }
+    return HasInput() ? state_.keyboard_ready_at : kNever;
+}
+
+uint64_t ConsoleDeviceType::KeyboardInterruptAt(uint64_t now)
+{
+    if (input_begin_ < input_end_ || (!is_input_end_ && backend_->IsReadReady() && HasInput()))
+    {
+        return state_.keyboard_ready_at;
+    }
+    if (is_input_end_)
+    {
+        return kNever;
+    }
+    return std::max(state_.keyboard_ready_at, now + kKeyboardLatency);
+}
+
+uint64_t ConsoleDeviceType::InterruptAt(uint64_t now)
+{
+    uint64_t interrupt_at = kNever;
+    if (state_.is_keyboard_interrupt)
+    {
+        interrupt_at = KeyboardInterruptAt(now);
+    }
+    if (state_.is_timer_interrupt)
+    {
+        interrupt_at = std::min(interrupt_at, state_.timer_ready_at);
+    }
+    return interrupt_at;
+}
+
+uint16_t ConsoleDeviceType::TakeInterrupt(uint64_t now)
+{
+    if (state_.is_keyboard_interrupt && now >= KeyboardInterruptAt(now))
+    {
+        return kLC3KeyboardVector;
+    }
+    if (state_.is_timer_interrupt && now >= state_.timer_ready_at)
+    {
+        state_.timer_ready_at = now + state_.timer_period - (now - state_.timer_ready_at) % state_.timer_period;
+        return kLC3TimerVector;
+    }
+    return 0;
+}
+
+uint16_t ConsoleDeviceType::GetChar()
+{
+    if (!HasInput())
+    {
+        // the end of input reads as xFF, as it always has
+        return 0xFF;
+    }
+    return uint8_t(input_buffer_[input_begin_++]);
+}
+
+void ConsoleDeviceType::Flush()
+{
+    if (!output_buffer_.empty())
+    {
+        backend_->Write(output_buffer_.data(), output_buffer_.size());
+        output_buffer_.clear();
+    }
+}
@@ -0,0 +1,190 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : memory-mapped console and timer devices of LC-3
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+// Device registers live in xFE00 - xFFFF
+const uint16_t kLC3DeviceBase = 0xFE00;
+const uint16_t kLC3KBSR = 0xFE00;
+const uint16_t kLC3KBDR = 0xFE02;
+const uint16_t kLC3DSR = 0xFE04;
+const uint16_t kLC3DDR = 0xFE06;
+// timer: TSR[15] ready, TSR[14] interrupt enable; TMR is the period in
+// instructions, writing it restarts the timer, 0 stops it
+const uint16_t kLC3TSR = 0xFE08;
+const uint16_t kLC3TMR = 0xFE0A;
+const uint16_t kLC3MCR = 0xFFFE;
+const uint16_t kLC3DeviceReady = 0x8000;
+// KBSR[14] / TSR[14]
+const uint16_t kLC3InterruptEnable = 0x4000;
+
+// Interrupt vectors, the handler address is at x0100 + vector
+const uint16_t kLC3KeyboardVector = 0x80;
+const uint16_t kLC3TimerVector = 0x81;
+const uint16_t kLC3InterruptTable = 0x0100;
+// both devices interrupt at priority level 4
+const uint16_t kLC3InterruptPriority = 4;
+
+// Device timing is counted in instructions, not wall-clock time, so a
+// run is deterministic and polling loops can be skipped exactly
+const uint64_t kKeyboardLatency = 1000;
+const uint64_t kDisplayLatency = 20;
+const uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+// Console bytes are moved to and from the backend in chunks of this size,
+// output is also written out on HALT, MCR stop, and before blocking on input
+const size_t kConsoleChunkSize = 1 << 16;
+
+// Where the console bytes come from and go to
+class ConsoleBackendType
+{
+public:
+    virtual ~ConsoleBackendType() = default;
+    // Up to `size` bytes into `buffer`, 0 at the end of the input.
+    // May block until at least one byte is there.
+    virtual size_t Read(char *buffer, size_t size) = 0;
+    virtual void Write(const char *data, size_t size) = 0;
+    // true when Read would return without waiting
+    virtual bool IsReadReady() = 0;
+};
+
+// std::istream / std::ostream, one byte per Read: the stream buffers
+// already, and the debugger reads its commands from the same stream
+class StreamBackendType : public ConsoleBackendType
+{
+private:
+    std::istream *in_;
+    std::ostream *out_;
+
+public:
+    StreamBackendType(std::istream &in, std::ostream &out) : in_(&in), out_(&out) {}
+    size_t Read(char *buffer, size_t size) override;
+    void Write(const char *data, size_t size) override;
+    bool IsReadReady() override { return in_->rdbuf()->in_avail() != 0; }
+};
+
+// read(2) / write(2) on file descriptors, stdin / stdout by default
+class PipeBackendType : public ConsoleBackendType
+{
+protected:
+    int in_fd_;
+    int out_fd_;
+
+public:
+    explicit PipeBackendType(int in_fd = STDIN_FILENO, int out_fd = STDOUT_FILENO)
+        : in_fd_(in_fd), out_fd_(out_fd)
+    {
+    }
+    size_t Read(char *buffer, size_t size) override;
+    void Write(const char *data, size_t size) override;
+    bool IsReadReady() override;
+};
+
+// Input from a file, output to stdout or a file
+class FileBackendType : public PipeBackendType
+{
+public:
+    FileBackendType() : PipeBackendType(-1, STDOUT_FILENO) {}
+    ~FileBackendType() override;
+    // an empty `output_filename` keeps stdout
+    int Open(const std::string &input_filename, const std::string &output_filename = "");
+    FileBackendType(const FileBackendType &) = delete;
+    FileBackendType &operator=(const FileBackendType &) = delete;
+};
+
+// Input from a string, output collected into one, for machines that
+// run side by side without a terminal
+class MemoryBackendType : public ConsoleBackendType
+{
+private:
+    std::string input_;
+    size_t input_position_ = 0;
+    std::string output_;
+
+public:
+    explicit MemoryBackendType(std::string input = "") : input_(std::move(input)) {}
+    size_t Read(char *buffer, size_t size) override;
+    void Write(const char *data, size_t size) override;
+    bool IsReadReady() override { return true; }
+    const std::string &GetOutput() const { return output_; }
+};
+
+// Registers and timing of the devices, saved in snapshots. Buffered
+// console input belongs to the backend and is not part of it.
+struct DeviceStateType
+{
+    // instruction counts at which the devices turn ready
+    uint64_t keyboard_ready_at = 0;
+    uint64_t display_ready_at = 0;
+    uint64_t timer_ready_at = kNever;
+    uint16_t timer_period = 0;
+    bool is_keyboard_interrupt = false;
+    bool is_timer_interrupt = false;
+    uint16_t last_key = 0;
+    bool is_running = true;
+};
+
+class ConsoleDeviceType
+{
+private:
+    std::shared_ptr<ConsoleBackendType> backend_ = std::make_shared<PipeBackendType>();
+    std::unique_ptr<char[]> input_buffer_;
+    size_t input_begin_ = 0;
+    size_t input_end_ = 0;
+    bool is_input_end_ = false;
+    std::string output_buffer_;
+    DeviceStateType state_;
+
+    // refill the input buffer when it is empty, false at the end of input
+    bool HasInput();
+    // ReadyAt(kLC3KBSR) without waiting for input: while there is none
+    // yet, the keyboard is looked at again kKeyboardLatency later
+    uint64_t KeyboardInterruptAt(uint64_t now);
+
+public:
+    ~ConsoleDeviceType() { Flush(); }
+    void SetBackend(std::shared_ptr<ConsoleBackendType> backend);
+    const DeviceStateType &GetState() const { return state_; }
+    void SetState(const DeviceStateType &state) { state_ = state; }
+
+    // `now` is the number of instructions executed so far
+    uint16_t Read(uint16_t address, uint64_t now);
+    void Write(uint16_t address, uint16_t value, uint64_t now);
+    // When will the status register at `address` read as ready,
+    // kNever if it never will (no more input, timer stopped)
+    uint64_t ReadyAt(uint16_t address);
+    // cleared by writing MCR[15] = 0
+    bool IsRunning() const { return state_.is_running; }
+
+    // Earliest instruction count after `now` at which an enabled device
+    // may interrupt, kNever if none will. Never waits for input.
+    uint64_t InterruptAt(uint64_t now);
+    // Vector of the interrupt raised at `now`, 0 if there is none. The
+    // timer is acknowledged by taking its interrupt, the keyboard by
+    // reading KBDR in the handler.
+    uint16_t TakeInterrupt(uint64_t now);
+
+    // For the built-in service routines
+    uint16_t GetChar();
+    void PutChar(char ch)
+    {
+        output_buffer_.push_back(ch);
+        if (output_buffer_.size() >= kConsoleChunkSize)
+        {
+            Flush();
+        }
+    }
+    void Flush();
+};
@@ -0,0 +1,539 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for small disassembler
+ */
+
+#include "disassembler.h"
+
+#include <algorithm>
+#include <array>
+#include <thread>
+
+namespace
+{
+
+using DisassembleFunction = std::string (*)(uint16_t instruction, uint16_t address,
+                                            const SymbolTableType &symbols);
+
+std::string Register(uint16_t instruction, int shift)
+{
+    return "R" + std::to_string((instruction >> shift) & 0x7);
+}
+
+std::string Immediate(uint16_t instruction, int bit_count)
+{
+    int value = instruction & ((1 << bit_count) - 1);
+    if (value >> (bit_count - 1))
+    {
+        value -= 1 << bit_count;
+    }
+    return "#" + std::to_string(value);
+}
+
+std::string Target(uint16_t instruction, uint16_t address, int bit_count,
+                   const SymbolTableType &symbols)
+{
+    int offset = instruction & ((1 << bit_count) - 1);
+    if (offset >> (bit_count - 1))
+    {
+        offset -= 1 << bit_count;
+    }
+    return symbols.Symbolize(address + 1 + offset);
+}
+
+std::string Fill(uint16_t instruction)
+{
+    return ".FILL " + FormatAddress(instruction);
+}
+
+std::string DisassembleBR(uint16_t instruction, uint16_t address, const SymbolTableType &symbols)
+{
+    if ((instruction & 0x0E00) == 0)
+    {
+        // never taken, data rather than code
+        return Fill(instruction);
+    }
+    std::string str = "BR";
+    if (instruction & 0x0800)
+        str.push_back('n');
+    if (instruction & 0x0400)
+        str.push_back('z');
+    if (instruction & 0x0200)
+        str.push_back('p');
+    return str + " " + Target(instruction, address, 9, symbols);
+}
+
+std::string DisassembleOperate(const std::string &name, uint16_t instruction)
+{
+    std::string str = name + " " + Register(instruction, 9) + ", " + Register(instruction, 6) + ", ";
+    if (instruction & 0x20)
+    {
+        return str + Immediate(instruction, 5);
+    }
+    if (instruction & 0x18)
+    {
+        // bits [4:3] must be 0
+        return Fill(instruction);
+    }
+    return str + Register(instruction, 0);
+}
+
+std::string DisassembleADD(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    return DisassembleOperate("ADD", instruction);
+}
+
+std::string DisassembleAND(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    return DisassembleOperate("AND", instruction);
+}
+
+std::string DisassemblePCRelative(const std::string &name, uint16_t instruction, uint16_t address,
+                                  const SymbolTableType &symbols)
+{
+    return name + " " + Register(instruction, 9) + ", " + Target(instruction, address, 9, symbols);
+}
+
+std::string DisassembleLD(uint16_t instruction, uint16_t address, const SymbolTableType &symbols)
+{
+    return DisassemblePCRelative("LD", instruction, address, symbols);
+}
+
+std::string DisassembleST(uint16_t instruction, uint16_t address, const SymbolTableType &symbols)
+{
+    return DisassemblePCRelative("ST", instruction, address, symbols);
+}
+
+std::string DisassembleLDI(uint16_t instruction, uint16_t address, const SymbolTableType &symbols)
+{
+    return DisassemblePCRelative("LDI", instruction, address, symbols);
+}
+
+std::string DisassembleSTI(uint16_t instruction, uint16_t address, const SymbolTableType &symbols)
+{
+    return DisassemblePCRelative("STI", instruction, address, symbols);
+}
+
+std::string DisassembleLEA(uint16_t instruction, uint16_t address, const SymbolTableType &symbols)
+{
+    return DisassemblePCRelative("LEA", instruction, address, symbols);
+}
+
+std::string DisassembleJSR(uint16_t instruction, uint16_t address, const SymbolTableType &symbols)
+{
+    if (instruction & 0x0800)
+    {
+        return "JSR " + Target(instruction, address, 11, symbols);
+    }
+    if (instruction & 0x0E3F)
+    {
+        return Fill(instruction);
+    }
+    return "JSRR " + Register(instruction, 6);
+}
+
+std::string DisassembleBaseOffset(const std::string &name, uint16_t instruction)
+{
+    return name + " " + Register(instruction, 9) + ", " + Register(instruction, 6) + ", " +
+           Immediate(instruction, 6);
+}
+
+std::string DisassembleLDR(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    return DisassembleBaseOffset("LDR", instruction);
+}
+
+std::string DisassembleSTR(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    return DisassembleBaseOffset("STR", instruction);
+}
+
+std::string DisassembleRTI(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    return instruction == 0x8000 ? "RTI" : Fill(instruction);
+}
+
+std::string DisassembleNOT(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    if ((instruction & 0x3F) != 0x3F)
+    {
+        return Fill(instruction);
+    }
+    return "NOT " + Register(instruction, 9) + ", " + Register(instruction, 6);
+}
+
+std::string DisassembleJMP(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    if (instruction & 0x0E3F)
+    {
+        return Fill(instruction);
+    }
+    if (instruction == 0xC1C0)
+    {
+        return "RET";
+    }
+    return "JMP " + Register(instruction, 6);
+}
+
+std::string DisassembleReserved(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    return Fill(instruction);
+}
+
+std::string DisassembleTRAP(uint16_t instruction, uint16_t, const SymbolTableType &)
+{
+    const std::array<const char *, 6> kTrapNames({"GETC", "OUT", "PUTS", "IN", "PUTSP", "HALT"});
+    if (instruction & 0x0F00)
+    {
+        return Fill(instruction);
+    }
+    auto trap_vector = instruction & 0xFF;
+    if (trap_vector >= 0x20 && trap_vector <= 0x25)
+    {
+        return kTrapNames[trap_vector - 0x20];
+    }
+    return "TRAP x" + FormatAddress(trap_vector).substr(3);
+}
+
+// indexed by instruction[15:12]
+const std::array<DisassembleFunction, 16> kDisassembleTable({
+    DisassembleBR, DisassembleADD, DisassembleLD, DisassembleST,
+    DisassembleJSR, DisassembleAND, DisassembleLDR, DisassembleSTR,
+    DisassembleRTI, DisassembleNOT, DisassembleLDI, DisassembleSTI,
+    DisassembleJMP, DisassembleReserved, DisassembleLEA, DisassembleTRAP,
+});
+
+// What the listing needs to know about one word
+struct DecodedWordType
+{
+    // an instruction the assembler can encode again
+    bool is_instruction = false;
+    bool falls_through = true;
+    // LD, ST, LDI, STI, LEA: the target is data
+    bool is_data_reference = false;
+    // PC-relative target, -1 if none
+    int target = -1;
+};
+
+enum ItemKind
+{
+    INSTRUCTION,
+    FILL,
+    BLKW,
+    STRINGZ,
+};
+
+// One line of the listing, covering `count` words
+struct ItemType
+{
+    ItemKind kind;
+    uint16_t address;
+    uint16_t count;
+};
+
+int PCRelativeTarget(uint16_t instruction, uint16_t address, int bit_count)
+{
+    int offset = instruction & ((1 << bit_count) - 1);
+    if (offset >> (bit_count - 1))
+    {
+        offset -= 1 << bit_count;
+    }
+    return uint16_t(address + 1 + offset);
+}
+
+DecodedWordType DecodeWord(uint16_t instruction, uint16_t address)
+{
+    DecodedWordType decoded;
+    decoded.is_instruction = true;
+    switch (instruction >> 12)
+    {
+    case 0x0:
+        // BR
+        decoded.is_instruction = (instruction & 0x0E00) != 0;
+        decoded.falls_through = (instruction & 0x0E00) != 0x0E00;
+        decoded.target = PCRelativeTarget(instruction, address, 9);
+        break;
+    case 0x1:
+    case 0x5:
+        // ADD, AND
+        decoded.is_instruction = (instruction & 0x20) || !(instruction & 0x18);
+        break;
+    case 0x2:
+    case 0x3:
+    case 0xA:
+    case 0xB:
+    case 0xE:
+        // LD, ST, LDI, STI, LEA
+        decoded.is_data_reference = true;
+        decoded.target = PCRelativeTarget(instruction, address, 9);
+        break;
+    case 0x4:
+        // JSR, JSRR
+        if (instruction & 0x0800)
+        {
+            decoded.target = PCRelativeTarget(instruction, address, 11);
+        }
+        else
+        {
+            decoded.is_instruction = !(instruction & 0x0E3F);
+        }
+        break;
+    case 0x8:
+        // RTI
+        decoded.is_instruction = instruction == 0x8000;
+        decoded.falls_through = false;
+        break;
+    case 0x9:
+        // NOT
+        decoded.is_instruction = (instruction & 0x3F) == 0x3F;
+        break;
+    case 0xC:
+        // JMP, RET
+        decoded.is_instruction = !(instruction & 0x0E3F);
+        decoded.falls_through = false;
+        break;
+    case 0xD:
+        decoded.is_instruction = false;
+        break;
+    case 0xF:
+        // the assembler only knows the named service routines
+        decoded.is_instruction = (instruction & 0xFF00) == 0xF000 &&
+                                 (instruction & 0xFF) >= 0x20 && (instruction & 0xFF) <= 0x25;
+        decoded.falls_through = instruction != 0xF025;
+        break;
+    default:
+        break;
+    }
+    return decoded;
+}
+
+// Characters .STRINGZ can hold: FormatLine upper-cases the line, cuts
+// it at ';', turns ',' into blanks, and the string ends at a blank
+bool IsStringChar(uint16_t word)
+{
+    return word > ' ' && word < 0x7F && word != ',' && word != ';' && word != '"' &&
+           !(word >= 'a' && word <= 'z');
+}
+
+// Split [0, count) into at most `thread_count` chunks and run
+// `function(chunk, begin, end)` on each one in its own thread
+template <typename Function>
+void ParallelFor(size_t count, int thread_count, Function function)
+{
+    const size_t kMinChunkSize = 1024;
+    size_t chunk_count = std::max<size_t>(1, std::min<size_t>(thread_count, count / kMinChunkSize));
+    size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+    std::vector<std::thread> threads;
+    for (size_t chunk = 1; chunk < chunk_count; ++chunk)
+    {
+        threads.emplace_back(function, chunk, chunk * chunk_size,
+                             std::min(count, (chunk + 1) * chunk_size));
+    }
+    function(0, 0, std::min(count, chunk_size));
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+} // namespace
+
+std::string DisassembleImage(const std::vector<uint16_t> &words, uint16_t origin,
+                             const SymbolTableType &symbols, int thread_count)
+{
+    const size_t count = words.size();
+    auto is_in_image = [&](int address) {
+        return address >= origin && size_t(address - origin) < count;
+    };
+
+    // Decode every word, in parallel
+    std::vector<DecodedWordType> decoded(count);
+    ParallelFor(count, thread_count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            decoded[i] = DecodeWord(words[i], origin + i);
+        }
+    });
+
+    // Follow control flow from the entries to find the code
+    std::vector<bool> is_code(count);
+    std::vector<bool> is_data(count);
+    auto follow = [&](size_t entry) {
+        std::vector<size_t> work_list({entry});
+        while (!work_list.empty())
+        {
+            auto index = work_list.back();
+            work_list.pop_back();
+            if (index >= count || is_code[index] || !decoded[index].is_instruction)
+            {
+                continue;
+            }
+            is_code[index] = true;
+            const auto &word = decoded[index];
+            if (word.target != -1 && is_in_image(word.target))
+            {
+                if (word.is_data_reference)
+                {
+                    is_data[word.target - origin] = true;
+                }
+                else
+                {
+                    work_list.push_back(word.target - origin);
+                }
+            }
+            if (word.falls_through)
+            {
+                work_list.push_back(index + 1);
+            }
+        }
+    };
+    follow(0);
+    // labels that nothing reads as data are subroutines reached indirectly
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!symbols.GetLabel(origin + i).empty() && !is_data[i])
+        {
+            follow(i);
+        }
+    }
+
+    // Label everything code refers to
+    SymbolTableType labels;
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto name = symbols.GetLabel(origin + i);
+        if (!name.empty())
+        {
+            labels.AddLabel(name, origin + i);
+        }
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        int target = decoded[i].target;
+        if (!is_code[i] || target == -1)
+        {
+            continue;
+        }
+        if (!is_in_image(target))
+        {
+            // no label possible, keep the word as data
+            is_code[i] = false;
+            continue;
+        }
+        if (labels.GetLabel(target).empty())
+        {
+            auto name = "L" + FormatAddress(target).substr(1);
+            while (symbols.GetAddress(name) != -1)
+            {
+                name += "_";
+            }
+            labels.AddLabel(name, target);
+        }
+    }
+
+    // Group data into .BLKW and .STRINGZ where possible
+    std::vector<ItemType> items;
+    auto is_labeled = [&](size_t index) { return !labels.GetLabel(origin + index).empty(); };
+    // end of the current run of data, only its first word may carry a label
+    size_t end = 0;
+    for (size_t i = 0; i < count;)
+    {
+        if (is_code[i])
+        {
+            items.push_back({ItemKind::INSTRUCTION, uint16_t(origin + i), 1});
+            ++i;
+            continue;
+        }
+        if (i >= end || is_labeled(i))
+        {
+            end = i + 1;
+            while (end < count && !is_code[end] && !is_labeled(end))
+            {
+                ++end;
+            }
+        }
+        if (words[i] == 0)
+        {
+            size_t zero_end = i + 1;
+            while (zero_end < end && words[zero_end] == 0 && zero_end - i < 0xFFFF)
+            {
+                ++zero_end;
+            }
+            if (zero_end - i >= 2)
+            {
+                items.push_back({ItemKind::BLKW, uint16_t(origin + i), uint16_t(zero_end - i)});
+                i = zero_end;
+                continue;
+            }
+        }
+        size_t string_end = i;
+        while (string_end < end && IsStringChar(words[string_end]))
+        {
+            ++string_end;
+        }
+        if (string_end - i >= 2 && string_end < end && words[string_end] == 0)
+        {
+            items.push_back({ItemKind::STRINGZ, uint16_t(origin + i), uint16_t(string_end - i + 1)});
+            i = string_end + 1;
+            continue;
+        }
+        items.push_back({ItemKind::FILL, uint16_t(origin + i), 1});
+        ++i;
+    }
+
+    // Format the lines, in parallel
+    std::vector<std::string> chunks(std::max(1, thread_count));
+    ParallelFor(items.size(), thread_count, [&](size_t chunk, size_t begin, size_t end) {
+        auto &text = chunks[chunk];
+        for (size_t i = begin; i < end; ++i)
+        {
+            const auto &item = items[i];
+            auto label = labels.GetLabel(item.address);
+            text += label;
+            text.append(label.size() < 8 ? 8 - label.size() : 1, ' ');
+            const size_t index = item.address - origin;
+            switch (item.kind)
+            {
+            case ItemKind::INSTRUCTION:
+                text += DisassembleInstruction(words[index], item.address, labels);
+                break;
+            case ItemKind::BLKW:
+                text += ".BLKW #" + std::to_string(item.count);
+                break;
+            case ItemKind::STRINGZ:
+                text += ".STRINGZ \"";
+                for (size_t j = index; j + 1 < index + item.count; ++j)
+                {
+                    text.push_back(char(words[j]));
+                }
+                text += "\"";
+                break;
+            default:
+                text += Fill(words[index]);
+                if (decoded[index].is_instruction)
+                {
+                    text += " ; " + DisassembleInstruction(words[index], item.address, labels);
+                }
+                break;
+            }
+            text += "\n";
+        }
+    });
+
+    std::string listing = "        .ORIG " + FormatAddress(origin) + "\n";
+    for (const auto &text : chunks)
+    {
+        listing += text;
+    }
+    listing += "        .END\n";
+    return listing;
+}
+
+std::string DisassembleInstruction(uint16_t instruction, uint16_t address,
+                                   const SymbolTableType &symbols)
+{
+    return kDisassembleTable[instruction >> 12](instruction, address, symbols);
+}
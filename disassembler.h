@@ -0,0 +1,27 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : header file for small disassembler
+ */
+
+#pragma once
+
+#include "symbol.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Translate one instruction at `address` back into assembly, PC-relative
+// targets are symbolized with `symbols`
+std::string DisassembleInstruction(uint16_t instruction, uint16_t address,
+                                   const SymbolTableType &symbols);
+
+// Turn a whole image loaded at `origin` back into source the assembler
+// accepts. Code is told from data by following control flow from the
+// origin and from the labels in `symbols`; data becomes .FILL, .BLKW or
+// .STRINGZ. Decoding and formatting are split over `thread_count` threads.
+std::string DisassembleImage(const std::vector<uint16_t> &words, uint16_t origin,
+                             const SymbolTableType &symbols, int thread_count);
@@ -0,0 +1,160 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : A small disassembler for LC-3
+ */
+
+#include "assembler.h"
+#include "cmdline.h"
+#include "disassembler.h"
+#include "loader.h"
+
+#include <thread>
+#include <unistd.h>
+
+bool gIsErrorLogMode = false;
+bool gIsHexMode = false;
+bool gIsTimingMode = false;
+
+// Reassemble `listing` and compare the result with `words`,
+// returns the number of words that differ
+static int verifyListing(const std::string &listing, const std::vector<uint16_t> &words,
+                         uint16_t origin, const std::string &image_filename) {
+    char listing_filename[] = "/tmp/lc3dis_XXXXXX";
+    int fd = mkstemp(listing_filename);
+    if (fd < 0) {
+        std::cout << "Unable to create temporary file" << std::endl;
+        return -1;
+    }
+    close(fd);
+    std::string input_filename = listing_filename;
+    std::string output_filename = input_filename + ".bin";
+    std::ofstream(input_filename) << listing;
+
+    auto ass = assembler();
+    auto status = ass.assemble(input_filename, output_filename);
+    ImageType image;
+    if (status == 0) {
+        status = LoadImageFile(output_filename, image);
+    }
+    std::remove(input_filename.c_str());
+    std::remove(output_filename.c_str());
+    if (status != 0) {
+        std::cout << image_filename << ": reassembling failed with " << status << std::endl;
+        return -1;
+    }
+
+    int mismatch_count = 0;
+    if (image.words.size() != words.size()) {
+        std::cout << image_filename << ": " << words.size() << " words, reassembled "
+                  << image.words.size() << std::endl;
+        ++mismatch_count;
+    }
+    for (size_t i = 0; i < std::min(words.size(), image.words.size()); ++i) {
+        if (words[i] != image.words[i]) {
+            std::cout << image_filename << ": " << FormatAddress(origin + i) << " expected "
+                      << FormatAddress(words[i]) << " got " << FormatAddress(image.words[i])
+                      << std::endl;
+            ++mismatch_count;
+        }
+    }
+    return mismatch_count;
+}
+
+int main(int argc, char **argv) {
+    if (cmdOptionExists(argv, argv + argc, "-h")) {
+        std::cout << "This is a simple disassembler for LC-3." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mUsage\e[0m" << std::endl;
+        std::cout << "./disassembler \e[1m[OPTION]\e[0m ..." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mOptions\e[0m" << std::endl;
+        std::cout << "-h : print out help information" << std::endl;
+        std::cout << "-f : comma separated paths for the image files" << std::endl;
+        std::cout << "-b : the begin address of text images (default x3000)" << std::endl;
+        std::cout << "-y : the path for the label table (assembler -l)" << std::endl;
+        std::cout << "-o : the path for the output file (default stdout)" << std::endl;
+        std::cout << "-j : number of threads" << std::endl;
+        std::cout << "--verify : reassemble the output and compare the words" << std::endl;
+        return 0;
+    }
+
+    std::vector<std::string> image_filenames;
+    auto image_info = getCmdOption(argv, argv + argc, "-f");
+    std::stringstream image_stream(image_info.first ? image_info.second : "input.bin");
+    std::string image_filename;
+    while (std::getline(image_stream, image_filename, ',')) {
+        image_filenames.push_back(image_filename);
+    }
+
+    int origin = kLC3DefaultOrigin;
+    auto origin_info = getCmdOption(argv, argv + argc, "-b");
+    if (origin_info.first) {
+        origin = parseAddress(origin_info.second);
+        if (origin < 0) {
+            std::cout << "Invalid begin address" << std::endl;
+            return -1;
+        }
+    }
+
+    SymbolTableType symbols;
+    auto symbol_info = getCmdOption(argv, argv + argc, "-y");
+    if (symbol_info.first && symbols.Load(symbol_info.second) != 0) {
+        std::cout << "Unable to open label table" << std::endl;
+        return -1;
+    }
+
+    int thread_count = std::max(1u, std::thread::hardware_concurrency());
+    auto thread_info = getCmdOption(argv, argv + argc, "-j");
+    if (thread_info.first) {
+        auto count = parseCount(thread_info.second);
+        if (count < 0) {
+            std::cout << "Invalid thread count" << std::endl;
+            return -1;
+        }
+        thread_count = std::max(1L, count);
+    }
+
+    bool is_verify_mode = cmdOptionExists(argv, argv + argc, "--verify");
+    auto output_info = getCmdOption(argv, argv + argc, "-o");
+    std::ofstream output_file;
+    if (output_info.first) {
+        output_file.open(output_info.second);
+        if (!output_file) {
+            std::cout << "Unable to open output file" << std::endl;
+            return -1;
+        }
+    }
+    std::ostream &out = output_info.first ? output_file : std::cout;
+
+    int failed_count = 0;
+    for (const auto &filename : image_filenames) {
+        ImageType image;
+        if (LoadImageFile(filename, image) != 0) {
+            std::cout << "Unable to load " << filename << std::endl;
+            ++failed_count;
+            continue;
+        }
+        uint16_t image_origin = image.origin != -1 ? image.origin : origin;
+        auto listing = DisassembleImage(image.words, image_origin, symbols, thread_count);
+
+        if (is_verify_mode) {
+            if (verifyListing(listing, image.words, image_origin, filename) != 0) {
+                ++failed_count;
+            }
+            continue;
+        }
+        if (image_filenames.size() > 1) {
+            out << "; " << filename << std::endl;
+        }
+        out << listing;
+    }
+
+    if (is_verify_mode) {
+        std::cout << image_filenames.size() - failed_count << "/" << image_filenames.size()
+                  << " images round-trip" << std::endl;
+    }
+    return failed_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for text output of words
+ */
+
+#include "formatter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LC3_FORMATTER_X86 1
+#endif
+
+static const char kHexDigits[] = "0123456789ABCDEF";
+
+static inline void FormatBinaryWord(uint16_t word, char *out)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        out[i] = '0' + ((word >> (15 - i)) & 1);
+    }
+    out[16] = '\n';
+}
+
+static inline void FormatHexWord(uint16_t word, char *out)
+{
+    out[0] = kHexDigits[(word >> 12) & 0xF];
+    out[1] = kHexDigits[(word >> 8) & 0xF];
+    out[2] = kHexDigits[(word >> 4) & 0xF];
+    out[3] = kHexDigits[word & 0xF];
+    out[4] = '\n';
+}
+
+#ifdef LC3_FORMATTER_X86
+
+// One word per iteration: spread the high byte over chars 0-7 and the
+// low byte over chars 8-15, test one bit per char, then '0' - (-1) = '1'
+__attribute__((target("ssse3"))) static size_t FormatBinaryWordsSSSE3(const uint16_t *words,
+                                                                      size_t count, char *out)
+{
+    const __m128i kSpread = _mm_setr_epi8(1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i kBits = _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+    const __m128i kZero = _mm_set1_epi8('0');
+    for (size_t i = 0; i < count; ++i)
+    {
+        __m128i bytes = _mm_shuffle_epi8(_mm_cvtsi32_si128(words[i]), kSpread);
+        __m128i is_set = _mm_cmpeq_epi8(_mm_and_si128(bytes, kBits), kBits);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_sub_epi8(kZero, is_set));
+        out[16] = '\n';
+        out += kBinaryWordLineLength;
+    }
+    return count * kBinaryWordLineLength;
+}
+
+// Four words per iteration: split bytes into nibbles, put them in
+// printing order, look the digits up with a shuffle and interleave
+// the newlines with another shuffle
+__attribute__((target("ssse3"))) static size_t FormatHexWordsSSSE3(const uint16_t *words,
+                                                                   size_t count, char *out)
+{
+    const __m128i kLowNibble = _mm_set1_epi8(0x0F);
+    // each word is little-endian, print the high byte first
+    const __m128i kOrder = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m128i kDigits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kHexDigits));
+    const __m128i kLines = _mm_setr_epi8(0, 1, 2, 3, -1, 4, 5, 6, 7, -1, 8, 9, 10, 11, -1, 12);
+    const __m128i kNewlines = _mm_setr_epi8(0, 0, 0, 0, '\n', 0, 0, 0, 0, '\n', 0, 0, 0, 0, '\n', 0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(words + i));
+        __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), kLowNibble);
+        __m128i low = _mm_and_si128(bytes, kLowNibble);
+        __m128i nibbles = _mm_shuffle_epi8(_mm_unpacklo_epi8(high, low), kOrder);
+        __m128i digits = _mm_shuffle_epi8(kDigits, nibbles);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                         _mm_or_si128(_mm_shuffle_epi8(digits, kLines), kNewlines));
+        // the rest of the fourth word
+        alignas(16) char tail[16];
+        _mm_store_si128(reinterpret_cast<__m128i *>(tail), digits);
+        out[16] = tail[13];
+        out[17] = tail[14];
+        out[18] = tail[15];
+        out[19] = '\n';
+        out += 4 * kHexWordLineLength;
+    }
+    for (; i < count; ++i)
+    {
+        FormatHexWord(words[i], out);
+        out += kHexWordLineLength;
+    }
+    return count * kHexWordLineLength;
+}
+
+static const bool kHasSSSE3 = __builtin_cpu_supports("ssse3");
+
+#endif
+
+size_t FormatBinaryWords(const uint16_t *words, size_t count, char *out)
+{
+#ifdef LC3_FORMATTER_X86
+    if (kHasSSSE3)
+    {
+        return FormatBinaryWordsSSSE3(words, count, out);
+    }
+#endif
+    for (size_t i = 0; i < count; ++i)
+    {
+        FormatBinaryWord(words[i], out + i * kBinaryWordLineLength);
+    }
+    return count * kBinaryWordLineLength;
+}
+
+size_t FormatHexWords(const uint16_t *words, size_t count, char *out)
+{
+#ifdef LC3_FORMATTER_X86
+    if (kHasSSSE3)
+    {
+        return FormatHexWordsSSSE3(words, count, out);
+    }
+#endif
+    for (size_t i = 0; i < count; ++i)
+    {
+        FormatHexWord(words[i], out + i * kHexWordLineLength);
+    }
+    return count * kHexWordLineLength;
+}
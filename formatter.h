@@ -0,0 +1,23 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : text output of words, binary or hex lines
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Length of the line of one word, newline included
+const size_t kBinaryWordLineLength = 17;
+const size_t kHexWordLineLength = 5;
+
+// Write each word as 16 '0'/'1' chars and '\n' into `out`, which must
+// hold count * kBinaryWordLineLength bytes. Returns the bytes written.
+size_t FormatBinaryWords(const uint16_t *words, size_t count, char *out);
+// Write each word as 4 upper case hex digits and '\n' into `out`, which
+// must hold count * kHexWordLineLength bytes. Returns the bytes written.
+size_t FormatHexWords(const uint16_t *words, size_t count, char *out);
@@ -0,0 +1,359 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for image loader
+ */
+
+#include "loader.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LC3_LOADER_X86 1
+#endif
+
+// Length of the binary / hex text line of one word, newline included
+const size_t kBinaryLineLength = 17;
+const size_t kHexLineLength = 5;
+
+static inline int HexDigitValue(char ch)
+{
+    if (ch >= '0' && ch <= '9')
+    {
+        return ch - '0';
+    }
+    if (ch >= 'A' && ch <= 'F')
+    {
+        return ch - 'A' + 10;
+    }
+    if (ch >= 'a' && ch <= 'f')
+    {
+        return ch - 'a' + 10;
+    }
+    return -1;
+}
+
+// Parse one line at `pos` in the slow way, for everything the kernels
+// below refuse (CRLF, blanks, last line without newline, ...). The line
+// length decides between binary and hex, as hex mode images end every
+// .STRINGZ with a binary line.
+static int ParseTextLine(const char *data, size_t size, size_t &pos, std::vector<uint16_t> &words)
+{
+    size_t begin = pos;
+    while (pos < size && data[pos] != '\n')
+    {
+        ++pos;
+    }
+    size_t end = pos;
+    if (pos < size)
+    {
+        // skip '\n'
+        ++pos;
+    }
+    while (begin < end && isspace(static_cast<unsigned char>(data[begin])))
+    {
+        ++begin;
+    }
+    while (end > begin && isspace(static_cast<unsigned char>(data[end - 1])))
+    {
+        --end;
+    }
+    if (begin == end)
+    {
+        return 0;
+    }
+
+    uint16_t word = 0;
+    if (end - begin == 16)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (data[i] != '0' && data[i] != '1')
+            {
+                // @ Error malformed line
+                return -2;
+            }
+            word = (word << 1) | (data[i] - '0');
+        }
+    }
+    else if (end - begin == 4)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            int digit = HexDigitValue(data[i]);
+            if (digit < 0)
+            {
+                return -2;
+            }
+            word = (word << 4) | digit;
+        }
+    }
+    else
+    {
+        return -2;
+    }
+    words.push_back(word);
+    return 0;
+}
+
+#ifdef LC3_LOADER_X86
+
+// Each kernel converts as many well-formed lines as it can from the
+// start of `data` and returns the number of bytes consumed. The first
+// malformed line is left to ParseTextLine.
+
+// 16 '0'/'1' chars -> one word: compare against '1' and movemask. The
+// bytes are reversed first because char 0 is bit 15.
+__attribute__((target("ssse3"))) static size_t
+ParseBinaryLinesSSSE3(const char *data, size_t size, std::vector<uint16_t> &words)
+{
+    const __m128i kReverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i kZero = _mm_set1_epi8('0');
+    const __m128i kOne = _mm_set1_epi8('1');
+    size_t pos = 0;
+    while (size - pos >= kBinaryLineLength && data[pos + 16] == '\n')
+    {
+        __m128i line = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos)), kReverse);
+        __m128i ones = _mm_cmpeq_epi8(line, kOne);
+        __m128i zeros = _mm_cmpeq_epi8(line, kZero);
+        if (_mm_movemask_epi8(_mm_or_si128(ones, zeros)) != 0xFFFF)
+        {
+            break;
+        }
+        words.push_back(uint16_t(_mm_movemask_epi8(ones)));
+        pos += kBinaryLineLength;
+    }
+    return pos;
+}
+
+// Same as above, two lines per iteration, one in each 128-bit lane
+__attribute__((target("avx2"))) static size_t
+ParseBinaryLinesAVX2(const char *data, size_t size, std::vector<uint16_t> &words)
+{
+    const __m256i kReverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                              15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256i kZero = _mm256_set1_epi8('0');
+    const __m256i kOne = _mm256_set1_epi8('1');
+    size_t pos = 0;
+    while (size - pos >= 2 * kBinaryLineLength && data[pos + 16] == '\n' &&
+           data[pos + kBinaryLineLength + 16] == '\n')
+    {
+        __m256i lines = _mm256_set_m128i(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos + kBinaryLineLength)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos)));
+        lines = _mm256_shuffle_epi8(lines, kReverse);
+        __m256i ones = _mm256_cmpeq_epi8(lines, kOne);
+        __m256i zeros = _mm256_cmpeq_epi8(lines, kZero);
+        if (_mm256_movemask_epi8(_mm256_or_si256(ones, zeros)) != -1)
+        {
+            break;
+        }
+        uint32_t mask = _mm256_movemask_epi8(ones);
+        words.push_back(uint16_t(mask));
+        words.push_back(uint16_t(mask >> 16));
+        pos += 2 * kBinaryLineLength;
+    }
+    return pos + ParseBinaryLinesSSSE3(data + pos, size - pos, words);
+}
+
+// Three "XXXX\n" lines per 16-byte load: chars -> nibbles, gather the
+// 12 digits with a shuffle, then combine them with two multiply-adds
+__attribute__((target("ssse3"))) static size_t
+ParseHexLinesSSSE3(const char *data, size_t size, std::vector<uint16_t> &words)
+{
+    const __m128i kGather = _mm_setr_epi8(0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13, -1, -1, -1, -1);
+    const __m128i kNibbleWeights = _mm_setr_epi8(16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 0, 0, 0, 0);
+    const __m128i kByteWeights = _mm_setr_epi16(256, 1, 256, 1, 256, 1, 0, 0);
+    // digits of the three lines, newlines at 4, 9 and 14
+    const int kDigitMask = 0x3DEF;
+    size_t pos = 0;
+    while (size - pos >= 16 && data[pos + 4] == '\n' && data[pos + 9] == '\n' &&
+           data[pos + 14] == '\n')
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+        __m128i is_decimal = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                           _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chars));
+        __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                         _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+        if ((_mm_movemask_epi8(_mm_or_si128(is_decimal, is_alpha)) & kDigitMask) != kDigitMask)
+        {
+            break;
+        }
+        __m128i nibbles = _mm_or_si128(
+            _mm_and_si128(is_decimal, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+            _mm_and_si128(is_alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+        __m128i bytes = _mm_maddubs_epi16(_mm_shuffle_epi8(nibbles, kGather), kNibbleWeights);
+        __m128i values = _mm_madd_epi16(bytes, kByteWeights);
+        alignas(16) uint32_t results[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(results), values);
+        words.push_back(uint16_t(results[0]));
+        words.push_back(uint16_t(results[1]));
+        words.push_back(uint16_t(results[2]));
+        pos += 3 * kHexLineLength;
+    }
+    return pos;
+}
+
+// .obj words are big-endian
+__attribute__((target("ssse3"))) static void SwapBytesSSSE3(const char *data, size_t count,
+                                                             uint16_t *words)
+{
+    const __m128i kSwap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 2 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(words + i), _mm_shuffle_epi8(chunk, kSwap));
+    }
+    for (; i < count; ++i)
+    {
+        words[i] = uint16_t((uint8_t(data[2 * i]) << 8) | uint8_t(data[2 * i + 1]));
+    }
+}
+
+static const bool kHasSSSE3 = __builtin_cpu_supports("ssse3");
+static const bool kHasAVX2 = __builtin_cpu_supports("avx2");
+
+#endif
+
+static size_t ParseTextLines(const char *data, size_t size, ImageFormat format,
+                             std::vector<uint16_t> &words)
+{
+#ifdef LC3_LOADER_X86
+    if (format == ImageFormat::BINARY_TEXT)
+    {
+        if (kHasAVX2)
+        {
+            return ParseBinaryLinesAVX2(data, size, words);
+        }
+        if (kHasSSSE3)
+        {
+            return ParseBinaryLinesSSSE3(data, size, words);
+        }
+    }
+    else if (kHasSSSE3)
+    {
+        return ParseHexLinesSSSE3(data, size, words);
+    }
+#endif
+    return 0;
+}
+
+ImageFormat DetectImageFormat(const char *data, size_t size)
+{
+    size_t end = 0;
+    while (end < size && data[end] != '\n')
+    {
+        ++end;
+    }
+    if (end > 0 && data[end - 1] == '\r')
+    {
+        --end;
+    }
+    if (end == 16 && std::all_of(data, data + end, [](char ch) { return ch == '0' || ch == '1'; }))
+    {
+        return ImageFormat::BINARY_TEXT;
+    }
+    if (end == 4 && std::all_of(data, data + end, [](char ch) { return HexDigitValue(ch) >= 0; }))
+    {
+        return ImageFormat::HEX_TEXT;
+    }
+    if (size == 0)
+    {
+        return ImageFormat::BINARY_TEXT;
+    }
+    return ImageFormat::OBJECT;
+}
+
+int ParseImage(const char *data, size_t size, ImageType &image)
+{
+    image.format = DetectImageFormat(data, size);
+    image.origin = -1;
+    image.words.clear();
+
+    if (image.format == ImageFormat::OBJECT)
+    {
+        if (size < 2 || size % 2 != 0)
+        {
+            // @ Error odd sized object file
+            return -2;
+        }
+        image.origin = (uint8_t(data[0]) << 8) | uint8_t(data[1]);
+        size_t count = size / 2 - 1;
+        image.words.resize(count);
+#ifdef LC3_LOADER_X86
+        if (kHasSSSE3)
+        {
+            SwapBytesSSSE3(data + 2, count, image.words.data());
+            return 0;
+        }
+#endif
+        for (size_t i = 0; i < count; ++i)
+        {
+            image.words[i] = uint16_t((uint8_t(data[2 * i + 2]) << 8) | uint8_t(data[2 * i + 3]));
+        }
+        return 0;
+    }
+
+    // roughly one word per line
+    size_t line_length = image.format == ImageFormat::BINARY_TEXT ? kBinaryLineLength : kHexLineLength;
+    image.words.reserve(size / line_length + 1);
+    size_t pos = 0;
+    while (pos < size)
+    {
+        pos += ParseTextLines(data + pos, size - pos, image.format, image.words);
+        if (pos >= size)
+        {
+            break;
+        }
+        auto status = ParseTextLine(data, size, pos, image.words);
+        if (status != 0)
+        {
+            return status;
+        }
+    }
+    return 0;
+}
+
+int LoadImageFile(const std::string &image_filename, ImageType &image)
+{
+    int fd = open(image_filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        // @ Image file read error
+        return -1;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    size_t size = file_stat.st_size;
+    if (size == 0)
+    {
+        close(fd);
+        return ParseImage(nullptr, 0, image);
+    }
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return -1;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    auto status = ParseImage(static_cast<const char *>(data), size, image);
+    munmap(data, size);
+    return status;
+}
@@ -0,0 +1,42 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : image loader shared by the simulator and other tools
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Text images carry no origin, they are loaded here unless told otherwise
+const uint16_t kLC3DefaultOrigin = 0x3000;
+
+enum ImageFormat
+{
+    // assembler output: 16 '0'/'1' chars per line
+    BINARY_TEXT,
+    // assembler output with -s: 4 hex digits per line
+    HEX_TEXT,
+    // big-endian words, the first one is the origin
+    OBJECT,
+};
+
+struct ImageType
+{
+    ImageFormat format = ImageFormat::BINARY_TEXT;
+    // origin from the .obj header, -1 for text images
+    int origin = -1;
+    std::vector<uint16_t> words;
+};
+
+// Guess the format from the first line
+ImageFormat DetectImageFormat(const char *data, size_t size);
+// Parse an image already in memory
+int ParseImage(const char *data, size_t size, ImageType &image);
+// Map `image_filename` into memory and parse it
+int LoadImageFile(const std::string &image_filename, ImageType &image);
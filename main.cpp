@@ -7,22 +7,11 @@
  */
 
 #include "assembler.h"
+#include "cmdline.h"
 
 bool gIsErrorLogMode = false;
 bool gIsHexMode = false;
-// A simple arguments parser
-std::pair<bool, std::string> getCmdOption(char **begin, char **end,
-                                          const std::string &option) {
-    char **itr = std::find(begin, end, option);
-    if (itr != end && ++itr != end) {
-        return std::make_pair(true, *itr);
-    }
-    return std::make_pair(false, "");
-}
-
-bool cmdOptionExists(char **begin, char **end, const std::string &option) {
-    return std::find(begin, end, option) != end;
-}
+bool gIsTimingMode = false;
 
 int main(int argc, char **argv) {
     // Print out Basic information about the assembler
@@ -35,40 +24,53 @@ int main(int argc, char **argv) {
                   << std::endl;
         std::cout << "\e[1mOptions\e[0m" << std::endl;
         std::cout << "-h : print out help information" << std::endl;
-        std::cout << "-f : the path for the input file" << std::endl;
+        std::cout << "-f : the path for the input file, - to stream from stdin" << std::endl;
+        std::cout << "[FILE] : more input files, named outputs the same way as -f" << std::endl;
         std::cout << "-e : print out error information" << std::endl;
-        std::cout << "-o : the path for the output file" << std::endl;
+        std::cout << "-o : the path for the output file, - to stream to stdout" << std::endl;
         std::cout << "-s : hex mode" << std::endl;
+        std::cout << "-l : also write the label table to a .sym file" << std::endl;
+        std::cout << "-O : peephole optimization (branch chaining, no-op removal)" << std::endl;
+        std::cout << "-t : print out phase timings and counters" << std::endl;
+        std::cout << "-j : same as -t, as one line of JSON" << std::endl;
         return 0;
     }
 
     auto input_info = getCmdOption(argv, argv + argc, "-f");
-    std::string input_filename;
     auto output_info = getCmdOption(argv, argv + argc, "-o");
-    std::string output_filename;
 
-    // Check the input file name
+    // * Batch Mode:
+    // * Every argument that is not an option is one more input file,
+    // * assembled next to its input; included files are only read once
+    std::vector<std::pair<std::string, std::string>> jobs;
     if (input_info.first) {
-        input_filename = input_info.second;
-    } else {
-        input_filename = "input.txt";
+        jobs.push_back({input_info.second, output_info.first ? output_info.second : ""});
     }
-
-    if (output_info.first) {
-        output_filename = output_info.second;
-    } else {
-        output_filename = "";
+    for (int i = 1; i < argc; ++i) {
+        std::string previous = argv[i - 1];
+        if (argv[i][0] != '-' && previous != "-f" && previous != "-o") {
+            jobs.push_back({argv[i], ""});
+        }
+    }
+    if (jobs.empty()) {
+        jobs.push_back({"input.txt", output_info.first ? output_info.second : ""});
     }
 
-    // Check output file name
-    if (output_filename.empty()) {
-        output_filename = input_filename;
-        if (output_filename.find('.') == std::string::npos) {
-            output_filename = output_filename + ".asm";
-        } else {
-            output_filename =
-                output_filename.substr(0, output_filename.rfind('.'));
-            output_filename = output_filename + ".asm";
+    // Check output file names: FILE.txt is written to FILE.asm, and an
+    // input that is an .asm file already to FILE.bin, never over itself
+    for (auto &job : jobs) {
+        auto &output_filename = job.second;
+        if (output_filename.empty() && job.first == "-") {
+            output_filename = "-";
+        } else if (output_filename.empty()) {
+            output_filename = job.first;
+            auto extension_position = output_filename.rfind('.');
+            bool is_asm_input = extension_position != std::string::npos &&
+                                output_filename.substr(extension_position) == ".asm";
+            if (extension_position != std::string::npos) {
+                output_filename = output_filename.substr(0, extension_position);
+            }
+            output_filename = output_filename + (is_asm_input ? ".bin" : ".asm");
         }
     }
 
@@ -83,11 +85,59 @@ int main(int argc, char **argv) {
         SetHexMode(true);
     }
 
-    auto ass = assembler();
-    auto status = ass.assemble(input_filename, output_filename);
+    bool is_timing_text = cmdOptionExists(argv, argv + argc, "-t");
+    bool is_timing_json = cmdOptionExists(argv, argv + argc, "-j");
+    if (is_timing_text || is_timing_json) {
+        // * Timing Mode:
+        // * Phases are timed only in this mode, counters are always kept
+        SetTimingMode(true);
+    }
 
-    if (gIsErrorLogMode) {
-        std::cout << std::dec << status << std::endl;
+    bool is_streaming = false;
+    for (const auto &job : jobs) {
+        is_streaming |= job.first == "-" || job.second == "-";
+    }
+    if (is_streaming) {
+        // * Streaming Mode:
+        // * With - as the input or the output, both scans are done in one
+        // * pass and words are written as soon as their labels are known.
+        // * Reports go to stderr, stdout may be carrying the image.
+        std::ios::sync_with_stdio(false);
+    }
+    std::ostream &report = is_streaming ? std::cerr : std::cout;
+
+    for (auto &job : jobs) {
+        auto &input_filename = job.first;
+        auto &output_filename = job.second;
+        auto ass = assembler();
+        // * Optimization:
+        // * Removed instructions shift the code after them, labels follow
+        ass.enableOptimize(cmdOptionExists(argv, argv + argc, "-O"));
+        auto status = ass.assemble(input_filename, output_filename);
+
+        if (status == 0 && output_filename != "-" && cmdOptionExists(argv, argv + argc, "-l")) {
+            // * Label table:
+            // * Same name as the output file with .sym extension, used by
+            // * the simulator to symbolize addresses
+            auto label_filename = output_filename;
+            if (label_filename.find('.') != std::string::npos) {
+                label_filename = label_filename.substr(0, label_filename.rfind('.'));
+            }
+            status = ass.exportLabels(label_filename + ".sym");
+        }
+
+        // results of a batch are named after their input file
+        std::string name = jobs.size() > 1 ? input_filename : "";
+        if (gIsErrorLogMode) {
+            report << (name.empty() ? "" : name + ": ") << std::dec << status << std::endl;
+        }
+        if (is_timing_text) {
+            report << (name.empty() ? "" : name + ":\n");
+            ass.GetStats().Dump(report);
+        }
+        if (is_timing_json) {
+            ass.GetStats().DumpJson(report, name);
+        }
     }
     return 0;
 }
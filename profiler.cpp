@@ -0,0 +1,101 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for execution profile report
+ */
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+static inline double Percentage(uint64_t part, uint64_t total)
+{
+    return total == 0 ? 0.0 : 100.0 * part / total;
+}
+
+void ProfileType::Report(std::ostream &out, const SymbolTableType &symbols, int top_count) const
+{
+    uint64_t total = 0;
+    for (auto count : opcode_count)
+    {
+        total += count;
+    }
+    out << std::fixed << std::setprecision(2);
+    out << std::endl << "== Profile: " << total << " instructions ==" << std::endl;
+
+    // Hot spots
+    std::vector<std::pair<uint64_t, int>> hot_pcs;
+    for (int address = 0; address < kProfileAddressCount; ++address)
+    {
+        if (pc_count[address] != 0)
+        {
+            hot_pcs.push_back({pc_count[address], address});
+        }
+    }
+    std::sort(hot_pcs.begin(), hot_pcs.end(), [](const auto &a, const auto &b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    if (int(hot_pcs.size()) > top_count)
+    {
+        hot_pcs.resize(top_count);
+    }
+    out << std::endl << "-- Hot PCs --" << std::endl;
+    for (const auto &hot_pc : hot_pcs)
+    {
+        out << FormatAddress(hot_pc.second) << "  " << std::setw(12) << hot_pc.first << "  "
+            << std::setw(6) << Percentage(hot_pc.first, total) << "%  "
+            << symbols.Symbolize(hot_pc.second) << std::endl;
+    }
+
+    // Opcode classes
+    out << std::endl << "-- Opcodes --" << std::endl;
+    for (int opcode = 0; opcode < 16; ++opcode)
+    {
+        if (opcode_count[opcode] != 0)
+        {
+            out << std::setw(8) << std::left << kLC3OpcodeNames[opcode] << std::right
+                << std::setw(12) << opcode_count[opcode] << "  " << std::setw(6)
+                << Percentage(opcode_count[opcode], total) << "%" << std::endl;
+        }
+    }
+
+    // Branches
+    out << std::endl << "-- Branches (taken / not taken) --" << std::endl;
+    for (int address = 0; address < kProfileAddressCount; ++address)
+    {
+        auto taken = branch_taken[address];
+        auto not_taken = branch_not_taken[address];
+        if (taken + not_taken != 0)
+        {
+            out << FormatAddress(address) << "  " << std::setw(12) << taken << " / "
+                << std::setw(12) << not_taken << "  " << std::setw(6)
+                << Percentage(taken, taken + not_taken) << "% taken  "
+                << symbols.Symbolize(address) << std::endl;
+        }
+    }
+
+    // Memory regions
+    out << std::endl << "-- Memory (loads / stores) --" << std::endl;
+    for (int region = 0; region < kProfileRegionCount; ++region)
+    {
+        if (region_loads[region] + region_stores[region] != 0)
+        {
+            uint16_t begin = region << kProfileRegionBits;
+            uint16_t end = begin + (1 << kProfileRegionBits) - 1;
+            out << FormatAddress(begin) << "-" << FormatAddress(end) << "  " << std::setw(12)
+                << region_loads[region] << " / " << std::setw(12) << region_stores[region]
+                << "  " << symbols.Symbolize(begin) << std::endl;
+        }
+    }
+
+    // Call graph
+    out << std::endl << "-- Calls --" << std::endl;
+    for (const auto &edge : call_edges)
+    {
+        out << symbols.Symbolize(edge.first.first) << " -> " << symbols.Symbolize(edge.first.second)
+            << "  " << edge.second << std::endl;
+    }
+}
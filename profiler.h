@@ -0,0 +1,43 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : execution profile collected by the simulator (-p)
+ */
+
+#pragma once
+
+#include "symbol.h"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+const int kProfileAddressCount = 65536;
+// memory accesses are counted per 256-word region
+const int kProfileRegionBits = 8;
+const int kProfileRegionCount = kProfileAddressCount >> kProfileRegionBits;
+
+const std::array<const char *, 16> kLC3OpcodeNames({
+    "BR", "ADD", "LD", "ST", "JSR", "AND", "LDR", "STR",
+    "RTI", "NOT", "LDI", "STI", "JMP", "RESERVED", "LEA", "TRAP",
+});
+
+struct ProfileType
+{
+    std::vector<uint64_t> pc_count = std::vector<uint64_t>(kProfileAddressCount);
+    std::array<uint64_t, 16> opcode_count{};
+    std::vector<uint64_t> branch_taken = std::vector<uint64_t>(kProfileAddressCount);
+    std::vector<uint64_t> branch_not_taken = std::vector<uint64_t>(kProfileAddressCount);
+    std::array<uint64_t, kProfileRegionCount> region_loads{};
+    std::array<uint64_t, kProfileRegionCount> region_stores{};
+    // (address of JSR/JSRR, target) -> count
+    std::map<std::pair<uint16_t, uint16_t>, uint64_t> call_edges;
+
+    // Print the hot spot report, `top_count` hottest PCs first
+    void Report(std::ostream &out, const SymbolTableType &symbols, int top_count) const;
+};
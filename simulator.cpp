@@ -0,0 +1,845 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for small simulator
+ */
+
+#include "simulator.h"
+
+MemoryType::MemoryType()
+{
+    // every page starts as the same zero page
+    auto zero_page = std::make_shared<PageType>();
+    zero_page->fill(0);
+    pages_.fill(zero_page);
+}
+
+void MemoryType::Write(uint16_t address, uint16_t value)
+{
+    auto &page = pages_[address >> kLC3PageBits];
+    if (page.use_count() > 1)
+    {
+        // page is shared with a snapshot or another machine, copy it first
+        page = std::make_shared<PageType>(*page);
+    }
+    (*page)[address & (kLC3PageSize - 1)] = value;
+}
+
+int MemoryType::SharedPageCount() const
+{
+    int count = 0;
+    for (const auto &page : pages_)
+    {
+        if (page.use_count() > 1)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+simulator::simulator(const SnapshotType &snapshot)
+{
+    restore(snapshot);
+}
+
+// Load an image at `origin`: the assembler output (binary or hex mode)
+// or an .obj file, which brings its own origin
+int simulator::loadImage(const std::string &image_filename, uint16_t origin)
+{
+    ImageType image;
+    auto status = LoadImageFile(image_filename, image);
+    if (status != 0)
+    {
+        return status;
+    }
+    if (image.origin != -1)
+    {
+        origin = image.origin;
+    }
+
+    uint16_t address = origin;
+    for (auto word : image.words)
+    {
+        memory.Write(address++, word);
+    }
+    predecoded.reset();
+    registers.pc = origin;
+    return 0;
+}
+
+void simulator::setConsole(std::istream &in, std::ostream &out)
+{
+    console.SetBackend(std::make_shared<StreamBackendType>(in, out));
+}
+
+void simulator::setConsoleBackend(std::shared_ptr<ConsoleBackendType> backend)
+{
+    console.SetBackend(std::move(backend));
+}
+
+void simulator::enableFastForward(bool is_enabled)
+{
+    is_fast_forward = is_enabled;
+}
+
+SnapshotType simulator::takeSnapshot() const
+{
+    SnapshotType snapshot;
+    snapshot.registers = registers;
+    snapshot.memory = memory;
+    snapshot.instruction_count = instruction_count;
+    snapshot.halted = halted;
+    snapshot.devices = console.GetState();
+    return snapshot;
+}
+
+void simulator::restore(const SnapshotType &snapshot)
+{
+    registers = snapshot.registers;
+    memory = snapshot.memory;
+    instruction_count = snapshot.instruction_count;
+    halted = snapshot.halted;
+    console.SetState(snapshot.devices);
+    predecoded.reset();
+    breakpoint_stop_count = kNever;
+    is_waiting_forever = false;
+    // looked at before the first instruction, once the backend is set
+    interrupt_at = instruction_count;
+}
+
+void simulator::SetConditionCode(uint16_t value)
+{
+    uint16_t cc = kLC3ConditionP;
+    if (value == 0)
+    {
+        cc = kLC3ConditionZ;
+    }
+    else if (value & 0x8000)
+    {
+        cc = kLC3ConditionN;
+    }
+    registers.psr = (registers.psr & 0xFFF8) | cc;
+}
+
+int simulator::ExecuteTrap(uint16_t trap_vector)
+{
+    auto &r = registers.r;
+    r[7] = registers.pc;
+    auto routine = memory.Read(trap_vector);
+    if (routine != 0)
+    {
+        // An OS image is loaded, use its service routine
+        registers.pc = routine;
+        return 0;
+    }
+
+    // Built-in service routines
+    switch (trap_vector)
+    {
+    case 0x20:
+        // GETC
+        r[0] = console.GetChar();
+        break;
+    case 0x21:
+        // OUT
+        console.PutChar(char(r[0] & 0xFF));
+        break;
+    case 0x22:
+        // PUTS
+        for (uint16_t address = r[0]; memory.Read(address) != 0; ++address)
+        {
+            console.PutChar(char(memory.Read(address) & 0xFF));
+        }
+        break;
+    case 0x23:
+        // IN
+        for (auto ch : std::string("Input a character> "))
+        {
+            console.PutChar(ch);
+        }
+        r[0] = console.GetChar();
+        console.PutChar(char(r[0]));
+        break;
+    case 0x24:
+        // PUTSP
+        for (uint16_t address = r[0]; memory.Read(address) != 0; ++address)
+        {
+            auto word = memory.Read(address);
+            console.PutChar(char(word & 0xFF));
+            if (word >> 8)
+            {
+                console.PutChar(char(word >> 8));
+            }
+        }
+        break;
+    case kLC3TrapHalt:
+        // HALT
+        console.Flush();
+        halted = true;
+        break;
+    default:
+        // Unknown trap without OS image, ignore it
+        break;
+    }
+    return 0;
+}
+
+// Called once `instruction_count` reaches `interrupt_at`: enter the
+// handler of the interrupt raised, the same way as RTI leaves it
+void simulator::TakeInterrupt()
+{
+    interrupt_at = kNever;
+    if (((registers.psr >> 8) & 0x7) >= kLC3InterruptPriority)
+    {
+        // masked until RTI lowers the priority again
+        return;
+    }
+    auto vector = console.TakeInterrupt(instruction_count);
+    if (vector != 0)
+    {
+        auto &r = registers.r;
+        auto saved_psr = registers.psr;
+        if (registers.psr & kLC3PSRUserMode)
+        {
+            registers.saved_usp = r[6];
+            r[6] = registers.saved_ssp;
+        }
+        registers.psr = (registers.psr & ~(kLC3PSRUserMode | 0x0700)) | (kLC3InterruptPriority << 8);
+        WriteMemory(--r[6], saved_psr);
+        WriteMemory(--r[6], registers.pc);
+        registers.pc = memory.Read(kLC3InterruptTable + vector);
+    }
+    interrupt_at = console.InterruptAt(instruction_count);
+}
+
+unsigned simulator::GetFeatures() const
+{
+    unsigned features = 0;
+    if (profile)
+    {
+        features |= kFeatureProfile;
+    }
+    if (trace)
+    {
+        features |= kFeatureTrace;
+    }
+    if (stats)
+    {
+        features |= kFeatureStats;
+    }
+    if (!breakpoints.Empty())
+    {
+        features |= kFeatureDebug;
+    }
+    return features;
+}
+
+void simulator::enableProfile()
+{
+    profile = std::make_unique<ProfileType>();
+}
+
+void simulator::enableStats(const CostModelType &model)
+{
+    stats = std::make_unique<StatsType>();
+    cost_model = model;
+}
+
+int simulator::enableTrace(const std::string &trace_filename)
+{
+    trace = std::make_unique<TraceWriterType>();
+    auto status = trace->Open(trace_filename);
+    if (status != 0)
+    {
+        trace.reset();
+    }
+    return status;
+}
+
+template <unsigned kFeatures>
+uint16_t simulator::Load(uint16_t address)
+{
+    if constexpr (kFeatures & kFeatureProfile)
+    {
+        ++profile->region_loads[address >> kProfileRegionBits];
+    }
+    if constexpr (kFeatures & kFeatureStats)
+    {
+        ++stats->memory_loads;
+        stats->cycles += cost_model.memory_cycles;
+    }
+    if constexpr (kFeatures & kFeatureDebug)
+    {
+        if (breakpoints.IsPageMarked(address) && (breakpoints.GetFlags(address) & kWatchRead))
+        {
+            is_watch_hit = true;
+            watch_hit_address = address;
+            is_watch_hit_write = false;
+        }
+    }
+    if (address >= kLC3DeviceBase)
+    {
+        return LoadDevice<kFeatures>(address);
+    }
+    return memory.Read(address);
+}
+
+template <unsigned kFeatures>
+uint16_t simulator::LoadDevice(uint16_t address)
+{
+    auto value = console.Read(address, instruction_count);
+    if constexpr (!(kFeatures & kFeatureTrace))
+    {
+        // a trace has to show every instruction, never skip under it
+        if (is_fast_forward && !(value & kLC3DeviceReady) &&
+            (address == kLC3KBSR || address == kLC3DSR || address == kLC3TSR))
+        {
+            FastForwardPolling<kFeatures>(address, value);
+        }
+    }
+    return value;
+}
+
+// Called while the LDI at PC - 1 reads `value`, "not ready", from a
+// device status register. If it is a polling loop
+//     POLL LDI Rx, PTR    ; PTR .FILL xFE00 / xFE04
+//          BRzp POLL      ; or BRz / BRp
+// that branches back on `value` (zero, or positive with the IE bit set)
+// and falls through once the device is ready (negative), every iteration
+// until then reads `value` again, so those iterations are counted
+// instead of being executed.
+template <unsigned kFeatures>
+void simulator::FastForwardPolling(uint16_t status_address, uint16_t value)
+{
+    const uint16_t poll_pc = registers.pc - 1;
+    const auto poll = memory.Read(poll_pc);
+    const uint16_t pointer_address = poll_pc + 1 + SignExtend(poll & 0x1FF, 9);
+    if ((poll >> 12) != 0xA || memory.Read(pointer_address) != status_address)
+    {
+        return;
+    }
+    const auto branch = memory.Read(registers.pc);
+    const uint16_t not_ready_condition = value == 0 ? 0x0400 : 0x0200;
+    bool is_polling_loop = (branch >> 12) == 0x0 && !(branch & 0x0800) &&
+                           (branch & not_ready_condition) &&
+                           SignExtend(branch & 0x1FF, 9) == uint16_t(-2);
+    if (!is_polling_loop)
+    {
+        return;
+    }
+
+    // an interrupt inside the loop is taken at the same count as in
+    // exact mode, the skip stops in front of it
+    auto ready_at = std::min(console.ReadyAt(status_address), interrupt_at);
+    if (ready_at == kNever)
+    {
+        is_waiting_forever = true;
+        return;
+    }
+    // This LDI runs at `instruction_count`, the i-th LDI after it runs at
+    // instruction_count + 2i. The first one to see the device ready:
+    if (ready_at <= instruction_count)
+    {
+        return;
+    }
+    uint64_t ready_iteration = (ready_at - instruction_count + 1) / 2;
+    if (ready_iteration <= 1)
+    {
+        return;
+    }
+    uint64_t skipped_iterations = ready_iteration - 1;
+
+    instruction_count += 2 * skipped_iterations;
+    skipped_instruction_count += 2 * skipped_iterations;
+    if constexpr (kFeatures & kFeatureStats)
+    {
+        stats->instructions += 2 * skipped_iterations;
+        stats->cycles += skipped_iterations *
+                         (cost_model.opcode_cycles[0xA] + cost_model.opcode_cycles[0x0] +
+                          2 * cost_model.memory_cycles + cost_model.indirect_cycles);
+        stats->memory_loads += 2 * skipped_iterations;
+        stats->branches += skipped_iterations;
+        stats->branches_taken += skipped_iterations;
+    }
+    if constexpr (kFeatures & kFeatureProfile)
+    {
+        profile->pc_count[poll_pc] += skipped_iterations;
+        profile->pc_count[registers.pc] += skipped_iterations;
+        profile->opcode_count[0xA] += skipped_iterations;
+        profile->opcode_count[0x0] += skipped_iterations;
+        profile->branch_taken[registers.pc] += skipped_iterations;
+        profile->region_loads[pointer_address >> kProfileRegionBits] += skipped_iterations;
+        profile->region_loads[status_address >> kProfileRegionBits] += skipped_iterations;
+    }
+}
+
+template <unsigned kFeatures>
+void simulator::Store(uint16_t address, uint16_t value)
+{
+    if constexpr (kFeatures & kFeatureProfile)
+    {
+        ++profile->region_stores[address >> kProfileRegionBits];
+    }
+    if constexpr (kFeatures & kFeatureStats)
+    {
+        ++stats->memory_stores;
+        stats->cycles += cost_model.memory_cycles;
+    }
+    if constexpr (kFeatures & kFeatureTrace)
+    {
+        trace_record.write_kind = kTraceWriteMemory;
+        trace_record.destination = address;
+        trace_record.value = value;
+    }
+    if constexpr (kFeatures & kFeatureDebug)
+    {
+        if (breakpoints.IsPageMarked(address) && (breakpoints.GetFlags(address) & kWatchWrite))
+        {
+            is_watch_hit = true;
+            watch_hit_address = address;
+            is_watch_hit_write = true;
+        }
+    }
+    if (address >= kLC3DeviceBase)
+    {
+        console.Write(address, value, instruction_count);
+        halted = halted || !console.IsRunning();
+        interrupt_at = console.InterruptAt(instruction_count);
+        return;
+    }
+    memory.Write(address, value);
+    InvalidatePredecoded(address);
+}
+
+// Look at the instruction at `address` and the one after it, and fuse
+// them when they form one of the PredecodeKind pairs. A branch into the
+// second instruction uses the entry of its own address, so it is still
+// executed alone.
+void simulator::Predecode(uint16_t address, PredecodedType &entry) const
+{
+    entry.kind = PREDECODE_SINGLE;
+    entry.instruction = memory.Read(address);
+    if (address >= kLC3DeviceBase - 1)
+    {
+        // the pair would reach into the devices or wrap around
+        return;
+    }
+    const auto first = entry.instruction;
+    const auto second = memory.Read(address + 1);
+    const bool is_second_add_imm = (second >> 12) == 0x1 && (second & 0x20);
+
+    entry.first_dr = (first >> 9) & 0x7;
+    entry.first_sr = (first >> 6) & 0x7;
+    entry.second_dr = (second >> 9) & 0x7;
+    entry.second_sr = (second >> 6) & 0x7;
+    entry.second_imm = SignExtend(second & 0x1F, 5);
+    switch (first >> 12)
+    {
+    case 0x1:
+        // ADD + BR
+        if ((first & 0x20) && (second >> 12) == 0x0 && (second & 0x0E00))
+        {
+            entry.kind = FUSED_ADD_BR;
+            entry.first_imm = SignExtend(first & 0x1F, 5);
+            entry.conditions = (second >> 9) & 0x7;
+            entry.target = address + 2 + SignExtend(second & 0x1FF, 9);
+        }
+        break;
+    case 0x6:
+        // LDR + ADD
+        if (is_second_add_imm)
+        {
+            entry.kind = FUSED_LDR_ADD;
+            entry.first_imm = SignExtend(first & 0x3F, 6);
+        }
+        break;
+    case 0x5:
+        // AND #0 + ADD
+        if ((first & 0x3F) == 0x20 && is_second_add_imm && entry.second_sr == entry.first_dr)
+        {
+            entry.kind = FUSED_CLEAR_ADD;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void simulator::InvalidatePredecoded(uint16_t address)
+{
+    if (predecoded)
+    {
+        (*predecoded)[address].kind = PREDECODE_EMPTY;
+        (*predecoded)[uint16_t(address - 1)].kind = PREDECODE_EMPTY;
+    }
+}
+
+// Execute the pair at PC, counted as two instructions
+void simulator::ExecuteFused(const PredecodedType &entry)
+{
+    auto &r = registers.r;
+    switch (entry.kind)
+    {
+    case FUSED_ADD_BR:
+        r[entry.first_dr] = r[entry.first_sr] + entry.first_imm;
+        SetConditionCode(r[entry.first_dr]);
+        registers.pc = (registers.psr & entry.conditions) ? entry.target : registers.pc + 2;
+        instruction_count += 2;
+        break;
+    case FUSED_LDR_ADD:
+        // the load may reach a device, which looks at PC and the count
+        ++registers.pc;
+        ++instruction_count;
+        r[entry.first_dr] = Load<0>(r[entry.first_sr] + entry.first_imm);
+        ++registers.pc;
+        ++instruction_count;
+        r[entry.second_dr] = r[entry.second_sr] + entry.second_imm;
+        SetConditionCode(r[entry.second_dr]);
+        break;
+    case FUSED_CLEAR_ADD:
+        r[entry.first_dr] = 0;
+        r[entry.second_dr] = entry.second_imm;
+        SetConditionCode(r[entry.second_dr]);
+        registers.pc += 2;
+        instruction_count += 2;
+        break;
+    default:
+        break;
+    }
+}
+
+template <unsigned kFeatures>
+int simulator::Execute(uint16_t instruction)
+{
+    auto &r = registers.r;
+    auto &pc = registers.pc;
+    const int dr = (instruction >> 9) & 0x7;
+    const int sr1 = (instruction >> 6) & 0x7;
+    const uint16_t operand2 = (instruction & 0x20)
+                                  ? SignExtend(instruction & 0x1F, 5)
+                                  : r[instruction & 0x7];
+    const uint16_t pc_offset9 = SignExtend(instruction & 0x1FF, 9);
+    const uint16_t offset6 = SignExtend(instruction & 0x3F, 6);
+
+    switch (instruction >> 12)
+    {
+    case 0x0:
+    {
+        // BR
+        bool is_taken = (instruction >> 9) & registers.psr & 0x7;
+        if constexpr (kFeatures & kFeatureProfile)
+        {
+            auto &branch_count = is_taken ? profile->branch_taken : profile->branch_not_taken;
+            ++branch_count[uint16_t(pc - 1)];
+        }
+        if constexpr (kFeatures & kFeatureStats)
+        {
+            ++stats->branches;
+            stats->branches_taken += is_taken;
+        }
+        if (is_taken)
+        {
+            pc += pc_offset9;
+        }
+        break;
+    }
+    case 0x1:
+        // ADD
+        r[dr] = r[sr1] + operand2;
+        SetConditionCode(r[dr]);
+        break;
+    case 0x2:
+        // LD
+        r[dr] = Load<kFeatures>(pc + pc_offset9);
+        SetConditionCode(r[dr]);
+        break;
+    case 0x3:
+        // ST
+        Store<kFeatures>(pc + pc_offset9, r[dr]);
+        break;
+    case 0x4:
+    {
+        // JSR / JSRR
+        uint16_t target = (instruction & 0x800)
+                              ? uint16_t(pc + SignExtend(instruction & 0x7FF, 11))
+                              : r[sr1];
+        if constexpr (kFeatures & kFeatureProfile)
+        {
+            ++profile->call_edges[{uint16_t(pc - 1), target}];
+        }
+        r[7] = pc;
+        pc = target;
+        break;
+    }
+    case 0x5:
+        // AND
+        r[dr] = r[sr1] & operand2;
+        SetConditionCode(r[dr]);
+        break;
+    case 0x6:
+        // LDR
+        r[dr] = Load<kFeatures>(r[sr1] + offset6);
+        SetConditionCode(r[dr]);
+        break;
+    case 0x7:
+        // STR
+        Store<kFeatures>(r[sr1] + offset6, r[dr]);
+        break;
+    case 0x8:
+        // RTI
+        if (registers.psr & kLC3PSRUserMode)
+        {
+            return SimulatorStatus::PRIVILEGE_VIOLATION;
+        }
+        // the pops are part of RTI's opcode cost, like the pushes of
+        // entering the handler, not loads of the program
+        pc = memory.Read(r[6]++);
+        registers.psr = memory.Read(r[6]++);
+        if (registers.psr & kLC3PSRUserMode)
+        {
+            registers.saved_ssp = r[6];
+            r[6] = registers.saved_usp;
+        }
+        // an interrupt masked by the handler's priority may be taken now
+        interrupt_at = console.InterruptAt(instruction_count);
+        break;
+    case 0x9:
+        // NOT
+        r[dr] = ~r[sr1];
+        SetConditionCode(r[dr]);
+        break;
+    case 0xA:
+        // LDI
+        if constexpr (kFeatures & kFeatureStats)
+        {
+            stats->cycles += cost_model.indirect_cycles;
+        }
+        r[dr] = Load<kFeatures>(Load<kFeatures>(pc + pc_offset9));
+        SetConditionCode(r[dr]);
+        if (is_waiting_forever)
+        {
+            // reported once, a restore or new input may let it go on
+            is_waiting_forever = false;
+            // @ Polling a keyboard that will never get input
+            return SimulatorStatus::WAITING_FOREVER;
+        }
+        break;
+    case 0xB:
+        // STI
+        if constexpr (kFeatures & kFeatureStats)
+        {
+            stats->cycles += cost_model.indirect_cycles;
+        }
+        Store<kFeatures>(Load<kFeatures>(pc + pc_offset9), r[dr]);
+        break;
+    case 0xC:
+        // JMP / RET
+        pc = r[sr1];
+        break;
+    case 0xE:
+        // LEA
+        r[dr] = pc + pc_offset9;
+        break;
+    case 0xF:
+        // TRAP
+        if constexpr (kFeatures & kFeatureStats)
+        {
+            ++stats->traps;
+        }
+        return ExecuteTrap(instruction & 0xFF);
+    default:
+        // @ Reserved opcode 1101
+        return SimulatorStatus::ILLEGAL_OPCODE;
+    }
+    return 0;
+}
+
+template <unsigned kFeatures>
+int simulator::Step()
+{
+    if (instruction_count >= interrupt_at)
+    {
+        TakeInterrupt();
+    }
+    auto instruction = memory.Read(registers.pc);
+    if constexpr (kFeatures & kFeatureDebug)
+    {
+        is_watch_hit = false;
+    }
+    if constexpr (kFeatures & kFeatureProfile)
+    {
+        ++profile->pc_count[registers.pc];
+        ++profile->opcode_count[instruction >> 12];
+    }
+    if constexpr (kFeatures & kFeatureStats)
+    {
+        ++stats->instructions;
+        stats->cycles += cost_model.opcode_cycles[instruction >> 12];
+    }
+    if constexpr (kFeatures & kFeatureTrace)
+    {
+        trace_record.pc = registers.pc;
+        trace_record.instruction = instruction;
+        trace_record.write_kind = kTraceWriteNone;
+    }
+    ++registers.pc;
+    ++instruction_count;
+    auto status = Execute<kFeatures>(instruction);
+    if constexpr (kFeatures & kFeatureTrace)
+    {
+        // memory writes are filled in by Store, registers are found here
+        int written_register = -1;
+        switch (instruction >> 12)
+        {
+        case 0x1:
+        case 0x2:
+        case 0x5:
+        case 0x6:
+        case 0x9:
+        case 0xA:
+        case 0xE:
+            written_register = (instruction >> 9) & 0x7;
+            break;
+        case 0x4:
+            written_register = 7;
+            break;
+        case 0xF:
+        {
+            // built-in GETC and IN write R0, everything else R7
+            auto trap_vector = instruction & 0xFF;
+            bool is_builtin = memory.Read(trap_vector) == 0;
+            written_register = (is_builtin && (trap_vector == 0x20 || trap_vector == 0x23)) ? 0 : 7;
+            break;
+        }
+        default:
+            break;
+        }
+        if (written_register != -1)
+        {
+            trace_record.write_kind = kTraceWriteRegister;
+            trace_record.destination = written_register;
+            trace_record.value = registers.r[written_register];
+        }
+        trace->Push(trace_record);
+    }
+    return status;
+}
+
+template <unsigned kFeatures>
+int simulator::RunLoop(uint64_t max_steps)
+{
+    uint64_t steps = 0;
+    PredecodedType *cache = nullptr;
+    if constexpr (kFeatures == 0)
+    {
+        if (!predecoded)
+        {
+            predecoded = std::make_unique<std::array<PredecodedType, kLC3MemorySize>>();
+        }
+        cache = predecoded->data();
+    }
+    while (!halted)
+    {
+        if (max_steps != 0 && steps == max_steps)
+        {
+            return SimulatorStatus::STEP_LIMIT;
+        }
+        if constexpr (kFeatures & kFeatureDebug)
+        {
+            if (breakpoints.IsPageMarked(registers.pc) &&
+                (breakpoints.GetFlags(registers.pc) & kBreakpoint) &&
+                (instruction_count != breakpoint_stop_count || registers.pc != breakpoint_stop_pc))
+            {
+                breakpoint_stop_count = instruction_count;
+                breakpoint_stop_pc = registers.pc;
+                return SimulatorStatus::BREAKPOINT;
+            }
+        }
+        int status;
+        if constexpr (kFeatures == 0)
+        {
+            // * Predecode cache and superinstructions:
+            // * Only in the plain loop, every other loop has to see each
+            // * instruction on its own
+            if (instruction_count >= interrupt_at)
+            {
+                TakeInterrupt();
+            }
+            auto &entry = cache[registers.pc];
+            if (entry.kind == PREDECODE_EMPTY)
+            {
+                Predecode(registers.pc, entry);
+            }
+            // a pair never runs across an interrupt
+            if (entry.kind != PREDECODE_SINGLE && (max_steps == 0 || max_steps - steps >= 2) &&
+                instruction_count + 1 < interrupt_at)
+            {
+                ExecuteFused(entry);
+                steps += 2;
+                continue;
+            }
+            ++registers.pc;
+            ++instruction_count;
+            status = Execute<kFeatures>(entry.instruction);
+        }
+        else
+        {
+            status = Step<kFeatures>();
+        }
+        if (status != 0)
+        {
+            return status;
+        }
+        if constexpr (kFeatures & kFeatureDebug)
+        {
+            if (is_watch_hit)
+            {
+                return SimulatorStatus::WATCHPOINT;
+            }
+        }
+        ++steps;
+    }
+    return SimulatorStatus::HALTED;
+}
+
+template <unsigned... kFeatureSets>
+std::array<simulator::StepFunction, sizeof...(kFeatureSets)>
+simulator::MakeStepTable(std::integer_sequence<unsigned, kFeatureSets...>)
+{
+    return {&simulator::Step<kFeatureSets>...};
+}
+
+template <unsigned... kFeatureSets>
+std::array<simulator::RunLoopFunction, sizeof...(kFeatureSets)>
+simulator::MakeRunLoopTable(std::integer_sequence<unsigned, kFeatureSets...>)
+{
+    return {&simulator::RunLoop<kFeatureSets>...};
+}
+
+// Execute one instruction
+int simulator::step()
+{
+    static const auto kStepTable =
+        MakeStepTable(std::make_integer_sequence<unsigned, kFeatureCombinationCount>());
+    if (halted)
+    {
+        return SimulatorStatus::HALTED;
+    }
+    auto status = (this->*kStepTable[GetFeatures()])();
+    console.Flush();
+    return status;
+}
+
+// Run until HALT, an error, or `max_steps` instructions (0 for no limit)
+int simulator::run(uint64_t max_steps)
+{
+    static const auto kRunLoopTable =
+        MakeRunLoopTable(std::make_integer_sequence<unsigned, kFeatureCombinationCount>());
+    auto status = (this->*kRunLoopTable[GetFeatures()])(max_steps);
+    // whatever stopped the run, the output so far is written out
+    console.Flush();
+    return status;
+}
@@ -0,0 +1,263 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : header file for small simulator
+ */
+
+#pragma once
+
+#include "breakpoint.h"
+#include "device.h"
+#include "loader.h"
+#include "profiler.h"
+#include "stats.h"
+#include "trace.h"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+const int kLC3MemorySize = 65536;
+const int kLC3RegisterCount = 8;
+// Memory is shared between snapshots at page granularity
+const int kLC3PageBits = 8;
+const int kLC3PageSize = 1 << kLC3PageBits;
+const int kLC3PageCount = kLC3MemorySize / kLC3PageSize;
+
+const uint16_t kLC3TrapHalt = 0x25;
+
+// Condition codes kept in the low 3 bits of PSR
+const uint16_t kLC3ConditionN = 0x4;
+const uint16_t kLC3ConditionZ = 0x2;
+const uint16_t kLC3ConditionP = 0x1;
+// PSR[15]: 1 for user mode, 0 for supervisor mode
+const uint16_t kLC3PSRUserMode = 0x8000;
+
+// Optional features compiled into their own dispatch loop, so the
+// plain loop (no feature) pays nothing for them
+const unsigned kFeatureProfile = 1;
+const unsigned kFeatureTrace = 2;
+const unsigned kFeatureStats = 4;
+// only used while any breakpoint or watchpoint is set
+const unsigned kFeatureDebug = 8;
+// every combination of the features above gets its own loop
+const unsigned kFeatureCombinationCount = 16;
+
+enum SimulatorStatus
+{
+    HALTED = 0,
+    STEP_LIMIT = 1,
+    BREAKPOINT = 2,
+    WATCHPOINT = 3,
+    ILLEGAL_OPCODE = -2,
+    PRIVILEGE_VIOLATION = -3,
+    WAITING_FOREVER = -4,
+};
+
+// Entries of the predecode cache. A fused entry runs the instruction at
+// its address and the one after it in a single dispatch, any other
+// entry runs its instruction without fetching it from the pages.
+enum PredecodeKind : uint8_t
+{
+    PREDECODE_EMPTY = 0,
+    PREDECODE_SINGLE,
+    // ADD Rd, Rs, #imm + BR  (loop counters)
+    FUSED_ADD_BR,
+    // LDR Rd, Rb, #off + ADD Rx, Ry, #imm  (pointer walks)
+    FUSED_LDR_ADD,
+    // AND Rd, Rs, #0 + ADD Rx, Rd, #imm  (constant loads)
+    FUSED_CLEAR_ADD,
+};
+
+struct PredecodedType
+{
+    PredecodeKind kind = PREDECODE_EMPTY;
+    // the instruction at the entry's address
+    uint16_t instruction = 0;
+    uint8_t first_dr = 0;
+    uint8_t first_sr = 0;
+    uint8_t second_dr = 0;
+    uint8_t second_sr = 0;
+    // BR condition bits
+    uint8_t conditions = 0;
+    // sign extended immediates / offsets
+    uint16_t first_imm = 0;
+    uint16_t second_imm = 0;
+    uint16_t target = 0;
+};
+
+using PageType = std::array<uint16_t, kLC3PageSize>;
+
+// Copy-on-write memory for LC-3.
+// Copying a MemoryType only copies the page table, all pages stay shared
+// until one of the owners writes into it.
+class MemoryType
+{
+private:
+    std::array<std::shared_ptr<PageType>, kLC3PageCount> pages_;
+
+public:
+    MemoryType();
+    uint16_t Read(uint16_t address) const
+    {
+        return (*pages_[address >> kLC3PageBits])[address & (kLC3PageSize - 1)];
+    }
+    void Write(uint16_t address, uint16_t value);
+    // number of pages still shared with another machine or snapshot
+    int SharedPageCount() const;
+};
+
+struct RegisterFileType
+{
+    std::array<uint16_t, kLC3RegisterCount> r{};
+    uint16_t pc = kLC3DefaultOrigin;
+    uint16_t psr = kLC3PSRUserMode | kLC3ConditionZ;
+    // R6 of the other privilege mode
+    uint16_t saved_ssp = 0x3000;
+    uint16_t saved_usp = 0xFE00;
+};
+
+// Everything needed to resume a machine, cheap to copy thanks to MemoryType.
+// Console input already buffered or read is not part of it: a restored
+// machine reads on from whatever backend it is given.
+struct SnapshotType
+{
+    RegisterFileType registers;
+    MemoryType memory;
+    uint64_t instruction_count = 0;
+    bool halted = false;
+    DeviceStateType devices;
+};
+
+static inline uint16_t SignExtend(uint16_t value, int bit_count)
+{
+    if ((value >> (bit_count - 1)) & 1)
+    {
+        value |= 0xFFFF << bit_count;
+    }
+    return value;
+}
+
+class simulator
+{
+private:
+    RegisterFileType registers;
+    MemoryType memory;
+    uint64_t instruction_count = 0;
+    bool halted = false;
+
+    ConsoleDeviceType console;
+    // earliest instruction count at which a device may interrupt, checked
+    // before every instruction; kNever while no interrupt is enabled
+    uint64_t interrupt_at = kNever;
+    // skip device polling loops, see FastForwardPolling
+    bool is_fast_forward = false;
+    bool is_waiting_forever = false;
+    uint64_t skipped_instruction_count = 0;
+
+    std::unique_ptr<ProfileType> profile;
+    std::unique_ptr<TraceWriterType> trace;
+    // record of the instruction being executed, pushed after it finishes
+    TraceRecordType trace_record{};
+    std::unique_ptr<StatsType> stats;
+    CostModelType cost_model;
+
+    BreakpointMapType breakpoints;
+    bool is_watch_hit = false;
+    bool is_watch_hit_write = false;
+    uint16_t watch_hit_address = 0;
+    // where the last `run` stopped at a breakpoint, the next one starts by
+    // running that instruction if the machine has not moved since
+    uint64_t breakpoint_stop_count = kNever;
+    uint16_t breakpoint_stop_pc = 0;
+
+    // Only used by the plain loop, allocated on its first run. A write to
+    // W clears the entries of W and W - 1 (a pair starting there).
+    std::unique_ptr<std::array<PredecodedType, kLC3MemorySize>> predecoded;
+
+    unsigned GetFeatures() const;
+    void Predecode(uint16_t address, PredecodedType &entry) const;
+    void InvalidatePredecoded(uint16_t address);
+    void ExecuteFused(const PredecodedType &entry);
+    void SetConditionCode(uint16_t value);
+    int ExecuteTrap(uint16_t trap_vector);
+    void TakeInterrupt();
+    template <unsigned kFeatures>
+    uint16_t Load(uint16_t address);
+    template <unsigned kFeatures>
+    void Store(uint16_t address, uint16_t value);
+    template <unsigned kFeatures>
+    uint16_t LoadDevice(uint16_t address);
+    template <unsigned kFeatures>
+    void FastForwardPolling(uint16_t status_address, uint16_t value);
+    template <unsigned kFeatures>
+    int Execute(uint16_t instruction);
+    template <unsigned kFeatures>
+    int Step();
+    template <unsigned kFeatures>
+    int RunLoop(uint64_t max_steps);
+
+    using StepFunction = int (simulator::*)();
+    using RunLoopFunction = int (simulator::*)(uint64_t);
+    template <unsigned... kFeatureSets>
+    static std::array<StepFunction, sizeof...(kFeatureSets)>
+    MakeStepTable(std::integer_sequence<unsigned, kFeatureSets...>);
+    template <unsigned... kFeatureSets>
+    static std::array<RunLoopFunction, sizeof...(kFeatureSets)>
+    MakeRunLoopTable(std::integer_sequence<unsigned, kFeatureSets...>);
+
+public:
+    simulator() = default;
+    // Fork a new machine from a snapshot, memory pages are shared
+    // until either side writes them
+    explicit simulator(const SnapshotType &snapshot);
+
+    int loadImage(const std::string &image_filename, uint16_t origin);
+    // The console reads and writes `in` / `out` (stdin / stdout by default)
+    void setConsole(std::istream &in, std::ostream &out);
+    void setConsoleBackend(std::shared_ptr<ConsoleBackendType> backend);
+    // Accelerated mode: polling loops on KBSR / DSR jump straight to the
+    // device event, instruction counts stay the same as in exact mode
+    void enableFastForward(bool is_enabled);
+    // Start collecting a profile, the counters restart from zero
+    void enableProfile();
+    const ProfileType *GetProfile() const { return profile.get(); }
+    // Record every executed instruction into a binary trace file
+    int enableTrace(const std::string &trace_filename);
+    // Start counting cycles with `model`, the counters restart from zero
+    void enableStats(const CostModelType &model);
+    const StatsType *GetStats() const { return stats.get(); }
+    // `run` stops before an instruction with a breakpoint (except the one
+    // it stopped at last time, when resuming from there) and after an
+    // instruction touching a watched address
+    BreakpointMapType &GetBreakpoints() { return breakpoints; }
+    bool IsWatchHit() const { return is_watch_hit; }
+    bool IsWatchHitWrite() const { return is_watch_hit_write; }
+    uint16_t GetWatchHitAddress() const { return watch_hit_address; }
+
+    SnapshotType takeSnapshot() const;
+    void restore(const SnapshotType &snapshot);
+
+    int step();
+    int run(uint64_t max_steps);
+
+    const RegisterFileType &GetRegisters() const { return registers; }
+    void SetPC(uint16_t pc) { registers.pc = pc; }
+    uint16_t ReadMemory(uint16_t address) const { return memory.Read(address); }
+    void WriteMemory(uint16_t address, uint16_t value)
+    {
+        memory.Write(address, value);
+        InvalidatePredecoded(address);
+    }
+    uint64_t GetInstructionCount() const { return instruction_count; }
+    // instructions counted but not executed by the accelerated mode
+    uint64_t GetSkippedInstructionCount() const { return skipped_instruction_count; }
+    bool IsHalted() const { return halted; }
+    int SharedPageCount() const { return memory.SharedPageCount(); }
+};
@@ -0,0 +1,281 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : A small simulator for LC-3
+ */
+
+#include "cmdline.h"
+#include "debugger.h"
+#include "simulator.h"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// number of hot PCs in the profile report
+const int kProfileTopCount = 20;
+
+static void printRegisters(std::ostream &out, const simulator &sim) {
+    const auto &registers = sim.GetRegisters();
+    for (int i = 0; i < kLC3RegisterCount; ++i) {
+        out << "R" << i << " = x" << std::hex << std::uppercase
+            << registers.r[i] << std::endl;
+    }
+    out << "PC = x" << registers.pc << std::endl;
+    out << "PSR = x" << registers.psr << std::endl;
+    out << std::dec << "instructions = " << sim.GetInstructionCount()
+        << std::endl;
+    if (sim.GetSkippedInstructionCount() != 0) {
+        out << "executed = "
+            << sim.GetInstructionCount() - sim.GetSkippedInstructionCount()
+            << " (accelerated)" << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (cmdOptionExists(argv, argv + argc, "-h")) {
+        std::cout << "This is a simple simulator for LC-3." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mUsage\e[0m" << std::endl;
+        std::cout << "./simulator \e[1m[OPTION]\e[0m ..." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mOptions\e[0m" << std::endl;
+        std::cout << "-h : print out help information" << std::endl;
+        std::cout << "-f : the path for the image file (assembler output)" << std::endl;
+        std::cout << "-b : the begin address of the image (default x3000)" << std::endl;
+        std::cout << "-k : the path for an OS image loaded at x0000" << std::endl;
+        std::cout << "-n : stop after this many instructions" << std::endl;
+        std::cout << "-x : run until PC reaches this address, then snapshot" << std::endl;
+        std::cout << "-i : comma separated input files, each one runs in a" << std::endl
+                  << "     machine forked from the snapshot" << std::endl;
+        std::cout << "-j : run the -i inputs on this many threads (default 1)" << std::endl;
+        std::cout << "-e : print out registers and status" << std::endl;
+        std::cout << "-p : profile mode, print out a hot spot report" << std::endl;
+        std::cout << "-y : the path for the label table (assembler -l)" << std::endl;
+        std::cout << "-t : write a binary trace to this file (see trace_decoder)" << std::endl;
+        std::cout << "-s : print out cycles and other performance counters" << std::endl;
+        std::cout << "-c : the path for a cycle cost table (implies -s)" << std::endl;
+        std::cout << "-a : accelerated mode, skip KBSR / DSR polling loops" << std::endl;
+        std::cout << "-d : debugger, breakpoints and watchpoints on labels" << std::endl;
+        return 0;
+    }
+
+    auto image_info = getCmdOption(argv, argv + argc, "-f");
+    std::string image_filename = image_info.first ? image_info.second : "input.bin";
+
+    int origin = kLC3DefaultOrigin;
+    auto origin_info = getCmdOption(argv, argv + argc, "-b");
+    if (origin_info.first) {
+        origin = parseAddress(origin_info.second);
+        if (origin < 0) {
+            std::cout << "Invalid begin address" << std::endl;
+            return -1;
+        }
+    }
+
+    uint64_t max_steps = 0;
+    auto steps_info = getCmdOption(argv, argv + argc, "-n");
+    if (steps_info.first) {
+        auto count = parseCount(steps_info.second);
+        if (count < 0) {
+            std::cout << "Invalid step limit" << std::endl;
+            return -1;
+        }
+        max_steps = count;
+    }
+
+    bool is_verbose = cmdOptionExists(argv, argv + argc, "-e");
+    bool is_profile_mode = cmdOptionExists(argv, argv + argc, "-p");
+
+    bool is_stats_mode = cmdOptionExists(argv, argv + argc, "-s");
+    CostModelType cost_model;
+    auto cost_info = getCmdOption(argv, argv + argc, "-c");
+    if (cost_info.first) {
+        is_stats_mode = true;
+        if (cost_model.Load(cost_info.second) != 0) {
+            std::cout << "Unable to load cost table" << std::endl;
+            return -1;
+        }
+    }
+
+    SymbolTableType symbols;
+    auto symbol_info = getCmdOption(argv, argv + argc, "-y");
+    if (symbol_info.first && symbols.Load(symbol_info.second) != 0) {
+        std::cout << "Unable to open label table" << std::endl;
+        return -1;
+    }
+
+    bool is_accelerated = cmdOptionExists(argv, argv + argc, "-a");
+
+    simulator sim;
+    sim.enableFastForward(is_accelerated);
+    auto kernel_info = getCmdOption(argv, argv + argc, "-k");
+    if (kernel_info.first && sim.loadImage(kernel_info.second, 0) != 0) {
+        std::cout << "Unable to open OS image" << std::endl;
+        return -1;
+    }
+    if (sim.loadImage(image_filename, origin) != 0) {
+        std::cout << "Unable to open image" << std::endl;
+        return -1;
+    }
+
+    // * Fork point:
+    // * Everything before it (OS boot, program initialization) only
+    // * runs once, every input starts from the snapshot taken here
+    auto fork_info = getCmdOption(argv, argv + argc, "-x");
+    if (fork_info.first) {
+        int fork_address = parseAddress(fork_info.second);
+        if (fork_address < 0) {
+            std::cout << "Invalid fork address" << std::endl;
+            return -1;
+        }
+        while (!sim.IsHalted() && sim.GetRegisters().pc != fork_address) {
+            if (max_steps != 0 && sim.GetInstructionCount() >= max_steps) {
+                std::cout << "Step limit before fork point" << std::endl;
+                return SimulatorStatus::STEP_LIMIT;
+            }
+            auto status = sim.step();
+            if (status != 0) {
+                std::cout << "Error before fork point: " << status << std::endl;
+                return status;
+            }
+        }
+    }
+    const auto snapshot = sim.takeSnapshot();
+
+    std::vector<std::string> input_filenames;
+    auto input_info = getCmdOption(argv, argv + argc, "-i");
+    if (input_info.first) {
+        std::stringstream input_stream(input_info.second);
+        std::string input_filename;
+        while (std::getline(input_stream, input_filename, ',')) {
+            input_filenames.push_back(input_filename);
+        }
+    }
+
+    auto trace_info = getCmdOption(argv, argv + argc, "-t");
+
+    if (input_filenames.empty()) {
+        if (is_profile_mode) {
+            sim.enableProfile();
+        }
+        if (is_stats_mode) {
+            sim.enableStats(cost_model);
+        }
+        if (trace_info.first && sim.enableTrace(trace_info.second) != 0) {
+            std::cout << "Unable to open trace file" << std::endl;
+            return -1;
+        }
+        if (cmdOptionExists(argv, argv + argc, "-d")) {
+            // * Debugger:
+            // * Commands and the program share the console, unsynced so
+            // * keyboard interrupts can see what std::cin has buffered
+            std::ios::sync_with_stdio(false);
+            sim.setConsole(std::cin, std::cout);
+            return debugger(sim, symbols).loop(std::cin, std::cout);
+        }
+        auto status = sim.run(max_steps);
+        if (is_verbose) {
+            std::cout << std::endl << std::dec << status << std::endl;
+            printRegisters(std::cout, sim);
+        }
+        if (is_stats_mode) {
+            std::cout << std::endl;
+            sim.GetStats()->Dump(std::cout);
+        }
+        if (is_profile_mode) {
+            sim.GetProfile()->Report(std::cout, symbols, kProfileTopCount);
+        }
+        return 0;
+    }
+
+    auto thread_info = getCmdOption(argv, argv + argc, "-j");
+    int thread_count = 1;
+    if (thread_info.first) {
+        auto count = parseCount(thread_info.second);
+        if (count < 0) {
+            std::cout << "Invalid thread count" << std::endl;
+            return -1;
+        }
+        thread_count = std::max(1L, count);
+    }
+
+    // * Inputs:
+    // * Every machine has its console in memory, so they can run side by
+    // * side; the output and the reports of each one are printed in the
+    // * order of the inputs once it is done
+    std::vector<std::string> results(input_filenames.size());
+    std::vector<char> is_trace_failed(input_filenames.size(), false);
+    std::atomic<bool> is_failed{false};
+    std::atomic<size_t> next_input{0};
+    auto run_inputs = [&]() {
+        for (size_t i = next_input++; i < input_filenames.size() && !is_failed; i = next_input++) {
+            const auto &input_filename = input_filenames[i];
+            std::ostringstream result;
+            std::ifstream input_file(input_filename);
+            if (!input_file.is_open()) {
+                result << "Unable to open " << input_filename << std::endl;
+                results[i] = result.str();
+                continue;
+            }
+            std::ostringstream input;
+            input << input_file.rdbuf();
+            auto console = std::make_shared<MemoryBackendType>(input.str());
+
+            simulator child(snapshot);
+            child.setConsoleBackend(console);
+            child.enableFastForward(is_accelerated);
+            if (is_profile_mode) {
+                child.enableProfile();
+            }
+            if (is_stats_mode) {
+                child.enableStats(cost_model);
+            }
+            // * One trace per input: <trace file>.<input file name>, without
+            // * the directories of the input
+            if (trace_info.first &&
+                child.enableTrace(trace_info.second + "." +
+                                  input_filename.substr(input_filename.rfind('/') + 1)) != 0) {
+                result << "Unable to open trace file" << std::endl;
+                results[i] = result.str();
+                is_trace_failed[i] = true;
+                is_failed = true;
+                // @ Error at trace file, the inputs after it are not run
+                return;
+            }
+            auto status = child.run(max_steps);
+            result << console->GetOutput();
+            if (is_verbose) {
+                result << std::endl << input_filename << ": " << std::dec
+                       << status << std::endl;
+                printRegisters(result, child);
+            }
+            if (is_stats_mode) {
+                result << std::endl << input_filename << ":" << std::endl;
+                child.GetStats()->Dump(result);
+            }
+            if (is_profile_mode) {
+                child.GetProfile()->Report(result, symbols, kProfileTopCount);
+            }
+            results[i] = result.str();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < std::min<int>(thread_count, input_filenames.size()); ++i) {
+        threads.emplace_back(run_inputs);
+    }
+    run_inputs();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << results[i];
+        if (is_trace_failed[i]) {
+            return -1;
+        }
+    }
+    return 0;
+}
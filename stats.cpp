@@ -0,0 +1,80 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for cycle cost model and performance counters
+ */
+
+#include "stats.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+int CostModelType::Load(const std::string &cost_filename)
+{
+    std::ifstream cost_file(cost_filename);
+    if (!cost_file.is_open())
+    {
+        // @ Cost file read error
+        return -1;
+    }
+
+    std::string line;
+    while (std::getline(cost_file, line))
+    {
+        if (line.find(';') != std::string::npos)
+        {
+            line.erase(line.find(';'));
+        }
+        std::transform(line.begin(), line.end(), line.begin(), ::toupper);
+        std::stringstream line_stream(line);
+        std::string key;
+        uint64_t cycles;
+        if (!(line_stream >> key))
+        {
+            continue;
+        }
+        if (!(line_stream >> cycles))
+        {
+            // @ Error missing cycle count
+            return -2;
+        }
+
+        if (key == "MEMORY")
+        {
+            memory_cycles = cycles;
+            continue;
+        }
+        if (key == "INDIRECT")
+        {
+            indirect_cycles = cycles;
+            continue;
+        }
+        auto opcode = std::find(kLC3OpcodeNames.begin(), kLC3OpcodeNames.end(), key);
+        if (opcode == kLC3OpcodeNames.end())
+        {
+            // @ Error unknown key
+            return -3;
+        }
+        opcode_cycles[opcode - kLC3OpcodeNames.begin()] = cycles;
+    }
+    return 0;
+}
+
+void StatsType::Dump(std::ostream &out) const
+{
+    out << std::fixed << std::setprecision(3);
+    out << "cycles         = " << cycles << std::endl;
+    out << "instructions   = " << instructions << std::endl;
+    out << "CPI            = " << (instructions == 0 ? 0.0 : double(cycles) / instructions)
+        << std::endl;
+    out << "memory loads   = " << memory_loads << std::endl;
+    out << "memory stores  = " << memory_stores << std::endl;
+    out << "branches       = " << branches << std::endl;
+    out << "branches taken = " << branches_taken << std::endl;
+    out << "traps          = " << traps << std::endl;
+}
@@ -0,0 +1,42 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : cycle cost model and performance counters (-c / -s)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Cycles charged for each instruction. Loadable from a file of
+// "KEY CYCLES" lines, KEY being an opcode name (ADD, BR, ...) or
+//   MEMORY   : extra cycles for every data memory access
+//   INDIRECT : extra cycles for the indirection of LDI / STI
+// ';' starts a comment, keys not given keep their default.
+struct CostModelType
+{
+    std::array<uint64_t, 16> opcode_cycles;
+    uint64_t memory_cycles = 1;
+    uint64_t indirect_cycles = 1;
+
+    CostModelType() { opcode_cycles.fill(1); }
+    int Load(const std::string &cost_filename);
+};
+
+struct StatsType
+{
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t memory_loads = 0;
+    uint64_t memory_stores = 0;
+    uint64_t branches = 0;
+    uint64_t branches_taken = 0;
+    uint64_t traps = 0;
+
+    void Dump(std::ostream &out) const;
+};
@@ -0,0 +1,90 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for label table
+ */
+
+#include "symbol.h"
+#include "cmdline.h"
+
+#include <fstream>
+#include <sstream>
+
+int SymbolTableType::Load(const std::string &symbol_filename)
+{
+    std::ifstream symbol_file(symbol_filename);
+    if (!symbol_file.is_open())
+    {
+        // @ Symbol file read error
+        return -1;
+    }
+
+    std::string line;
+    while (std::getline(symbol_file, line))
+    {
+        std::stringstream line_stream(line);
+        std::string name;
+        std::string address_str;
+        if (!(line_stream >> name >> address_str) || address_str.size() < 2)
+        {
+            continue;
+        }
+        auto address = parseAddress(address_str);
+        if (address < 0)
+        {
+            // not an xNNNN address, skipped like a short line
+            continue;
+        }
+        AddLabel(name, address);
+    }
+    return 0;
+}
+
+void SymbolTableType::AddLabel(const std::string &name, uint16_t address)
+{
+    names_[address] = name;
+    addresses_[name] = address;
+}
+
+int SymbolTableType::GetAddress(const std::string &name) const
+{
+    auto iter = addresses_.find(name);
+    if (iter == addresses_.end())
+    {
+        // not found
+        return -1;
+    }
+    return iter->second;
+}
+
+std::string SymbolTableType::GetLabel(uint16_t address) const
+{
+    auto iter = names_.find(address);
+    if (iter == names_.end())
+    {
+        return "";
+    }
+    return iter->second;
+}
+
+std::string SymbolTableType::Symbolize(uint16_t address) const
+{
+    auto iter = names_.upper_bound(address);
+    if (iter == names_.begin())
+    {
+        return FormatAddress(address);
+    }
+    --iter;
+    if (address - iter->first >= kSymbolMaxOffset)
+    {
+        // too far from the label to be part of it
+        return FormatAddress(address);
+    }
+    if (iter->first == address)
+    {
+        return iter->second;
+    }
+    return iter->second + "+" + std::to_string(address - iter->first);
+}
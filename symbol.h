@@ -0,0 +1,48 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : label table exported by the assembler (-l)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+// addresses further than this from the previous label are not symbolized
+const int kSymbolMaxOffset = 0x100;
+
+// "x3000" style address
+static inline std::string FormatAddress(uint16_t address)
+{
+    const char *kHexDigits = "0123456789ABCDEF";
+    std::string str = "x";
+    for (int shift = 12; shift >= 0; shift -= 4)
+    {
+        str.push_back(kHexDigits[(address >> shift) & 0xF]);
+    }
+    return str;
+}
+
+// Label table read back from a .sym file, for symbolizing addresses
+class SymbolTableType
+{
+private:
+    std::map<uint16_t, std::string> names_;
+    std::unordered_map<std::string, uint16_t> addresses_;
+
+public:
+    int Load(const std::string &symbol_filename);
+    void AddLabel(const std::string &name, uint16_t address);
+    bool Empty() const { return names_.empty(); }
+    // address of `name`, -1 if not found
+    int GetAddress(const std::string &name) const;
+    // label defined exactly at `address`, empty if none
+    std::string GetLabel(uint16_t address) const;
+    // "LABEL", "LABEL+3" or "x3005" when no label precedes the address
+    std::string Symbolize(uint16_t address) const;
+};
@@ -0,0 +1,103 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : content for binary execution trace
+ */
+
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+
+TraceWriterType::TraceWriterType(int capacity_bits)
+    : records_(uint64_t(1) << capacity_bits), mask_((uint64_t(1) << capacity_bits) - 1)
+{
+}
+
+TraceWriterType::~TraceWriterType()
+{
+    Close();
+}
+
+int TraceWriterType::Open(const std::string &trace_filename)
+{
+    trace_file_ = std::fopen(trace_filename.c_str(), "wb");
+    if (trace_file_ == nullptr)
+    {
+        // @ Error at trace file
+        return -1;
+    }
+    const uint32_t header[2] = {kTraceMagic, sizeof(TraceRecordType)};
+    std::fwrite(header, sizeof(header), 1, trace_file_);
+    writer_ = std::thread(&TraceWriterType::Drain, this);
+    return 0;
+}
+
+void TraceWriterType::Close()
+{
+    if (trace_file_ == nullptr)
+    {
+        return;
+    }
+    is_stopping_.store(true, std::memory_order_release);
+    writer_.join();
+    std::fclose(trace_file_);
+    trace_file_ = nullptr;
+}
+
+// Writer thread: copy everything between tail and head to the file
+void TraceWriterType::Drain()
+{
+    const auto capacity = mask_ + 1;
+    while (true)
+    {
+        // read the flag before head, so nothing pushed before Close is missed
+        bool is_last_round = is_stopping_.load(std::memory_order_acquire);
+        auto head = head_.load(std::memory_order_acquire);
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (head == tail)
+        {
+            if (is_last_round)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        while (tail != head)
+        {
+            // at most up to the end of the ring in one write
+            auto begin = tail & mask_;
+            auto count = std::min(head - tail, capacity - begin);
+            std::fwrite(&records_[begin], sizeof(TraceRecordType), count, trace_file_);
+            tail += count;
+            tail_.store(tail, std::memory_order_release);
+        }
+    }
+    std::fflush(trace_file_);
+}
+
+bool ReadTraceFile(const std::string &trace_filename, std::vector<TraceRecordType> &records)
+{
+    std::FILE *trace_file = std::fopen(trace_filename.c_str(), "rb");
+    if (trace_file == nullptr)
+    {
+        return false;
+    }
+    uint32_t header[2] = {0, 0};
+    if (std::fread(header, sizeof(header), 1, trace_file) != 1 || header[0] != kTraceMagic ||
+        header[1] != sizeof(TraceRecordType))
+    {
+        std::fclose(trace_file);
+        return false;
+    }
+    TraceRecordType record;
+    while (std::fread(&record, sizeof(record), 1, trace_file) == 1)
+    {
+        records.push_back(record);
+    }
+    std::fclose(trace_file);
+    return true;
+}
@@ -0,0 +1,88 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : binary execution trace (-t) written by a background thread
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Kind of value written by a traced instruction
+const uint16_t kTraceWriteNone = 0;
+const uint16_t kTraceWriteRegister = 1;
+const uint16_t kTraceWriteMemory = 2;
+
+// "LC3T" followed by the record size, at the start of every trace file
+const uint32_t kTraceMagic = 0x5433434C;
+
+// One executed instruction, fixed size so the file can be read back
+// without any parsing
+struct TraceRecordType
+{
+    uint16_t pc;
+    uint16_t instruction;
+    uint16_t write_kind;
+    // register number or memory address
+    uint16_t destination;
+    uint16_t value;
+};
+static_assert(sizeof(TraceRecordType) == 10, "trace records must stay packed");
+
+// Single producer / single consumer ring buffer of trace records.
+// The simulator pushes records, a background thread drains them into
+// the trace file in large chunks.
+class TraceWriterType
+{
+private:
+    std::vector<TraceRecordType> records_;
+    const uint64_t mask_;
+    // written by the producer only
+    std::atomic<uint64_t> head_{0};
+    // written by the writer thread only
+    std::atomic<uint64_t> tail_{0};
+    // producer's last view of tail_, avoids reading it on every push
+    uint64_t cached_tail_ = 0;
+    std::atomic<bool> is_stopping_{false};
+    std::FILE *trace_file_ = nullptr;
+    std::thread writer_;
+
+    void Drain();
+
+public:
+    // `capacity_bits`: the ring holds 2^capacity_bits records
+    explicit TraceWriterType(int capacity_bits = 16);
+    ~TraceWriterType();
+    TraceWriterType(const TraceWriterType &) = delete;
+    TraceWriterType &operator=(const TraceWriterType &) = delete;
+
+    int Open(const std::string &trace_filename);
+    // Stop the writer thread after everything pushed so far is written
+    void Close();
+
+    void Push(const TraceRecordType &record)
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        while (head - cached_tail_ > mask_)
+        {
+            // ring is full, wait for the writer instead of losing records
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ > mask_)
+            {
+                std::this_thread::yield();
+            }
+        }
+        records_[head & mask_] = record;
+        head_.store(head + 1, std::memory_order_release);
+    }
+};
+
+// Read a whole trace file back, returns false on a bad file
+bool ReadTraceFile(const std::string &trace_filename, std::vector<TraceRecordType> &records);
@@ -0,0 +1,60 @@
+/*
+ * @Author       : liuly
+ * @Date         : 2026-10-19 10:57:12
+ * @LastEditors  : liuly
+ * @LastEditTime : 2026-10-19 10:57:12
+ * @Description  : Print out a binary trace written by the simulator
+ */
+
+#include "cmdline.h"
+#include "disassembler.h"
+#include "trace.h"
+
+#include <iomanip>
+#include <iostream>
+
+int main(int argc, char **argv) {
+    if (cmdOptionExists(argv, argv + argc, "-h")) {
+        std::cout << "Print out a binary trace written by simulator -t." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mUsage\e[0m" << std::endl;
+        std::cout << "./trace_decoder \e[1m[OPTION]\e[0m ..." << std::endl
+                  << std::endl;
+        std::cout << "\e[1mOptions\e[0m" << std::endl;
+        std::cout << "-h : print out help information" << std::endl;
+        std::cout << "-f : the path for the trace file" << std::endl;
+        std::cout << "-y : the path for the label table (assembler -l)" << std::endl;
+        return 0;
+    }
+
+    auto trace_info = getCmdOption(argv, argv + argc, "-f");
+    std::string trace_filename = trace_info.first ? trace_info.second : "trace.bin";
+
+    SymbolTableType symbols;
+    auto symbol_info = getCmdOption(argv, argv + argc, "-y");
+    if (symbol_info.first && symbols.Load(symbol_info.second) != 0) {
+        std::cout << "Unable to open label table" << std::endl;
+        return -1;
+    }
+
+    std::vector<TraceRecordType> records;
+    if (!ReadTraceFile(trace_filename, records)) {
+        std::cout << "Unable to read trace file" << std::endl;
+        return -1;
+    }
+
+    for (const auto &record : records) {
+        std::cout << FormatAddress(record.pc) << "  " << std::setw(12) << std::left
+                  << symbols.GetLabel(record.pc) << std::setw(24)
+                  << DisassembleInstruction(record.instruction, record.pc, symbols)
+                  << std::right;
+        if (record.write_kind == kTraceWriteRegister) {
+            std::cout << "R" << record.destination << " <- " << FormatAddress(record.value);
+        } else if (record.write_kind == kTraceWriteMemory) {
+            std::cout << "[" << FormatAddress(record.destination) << "] <- "
+                      << FormatAddress(record.value);
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}